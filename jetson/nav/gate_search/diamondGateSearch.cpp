@@ -5,7 +5,7 @@
 #include <iostream>
 #include <cmath>
 
-DiamondGateSearch::DiamondGateSearch( StateMachine* stateMachine, Rover* rover, const rapidjson::Document& roverConfig )
+DiamondGateSearch::DiamondGateSearch( StateMachine* stateMachine, Rover* rover, const NavConfig& roverConfig )
     : GateStateMachine(stateMachine, rover, roverConfig ) {}
 
 DiamondGateSearch::~DiamondGateSearch() {}
@@ -13,7 +13,8 @@ DiamondGateSearch::~DiamondGateSearch() {}
 void DiamondGateSearch::initializeSearch()
 {
     mGateSearchPoints.clear();
-    Odometry currOdom = mRover->roverStatus().odometry();
+    const Odometry& currOdom = mRover->roverStatus().odometry();
+    const LocalPoint currPoint = mRover->position();
     double diamondWidth = mRover->roverStatus().path().front().gate_width * 1.5;
     const double targetBearing = mRover->roverStatus().target().bearing;
     const double targetDist = mRover->roverStatus().target().distance;
@@ -24,16 +25,16 @@ void DiamondGateSearch::initializeSearch()
     double relTurn = theta + targetBearing;
     double angle = mod(currOdom.bearing_deg + relTurn, 360); // absolute bearing
 
-    Odometry corner1 = createOdom(currOdom, angle, distance, mRover);
+    LocalPoint corner1 = createPoint(currPoint, angle, distance);
 
     const double absolute_bear_to_target = mod(currOdom.bearing_deg + targetBearing, 360);
-    Odometry corner2 = createOdom(currOdom, absolute_bear_to_target, diamondWidth + targetDist, mRover);
+    LocalPoint corner2 = createPoint(currPoint, absolute_bear_to_target, diamondWidth + targetDist);
 
     relTurn = -1 * theta + targetBearing;
     angle = mod(currOdom.bearing_deg + relTurn, 360);
-    Odometry corner3 = createOdom(currOdom, angle, distance, mRover);
+    LocalPoint corner3 = createPoint(currPoint, angle, distance);
 
-    Odometry corner4 = createOdom(currOdom, mod(absolute_bear_to_target + 180, 360), diamondWidth - targetDist, mRover);
+    LocalPoint corner4 = createPoint(currPoint, mod(absolute_bear_to_target + 180, 360), diamondWidth - targetDist);
 
     mGateSearchPoints.push_back(corner1);
     mGateSearchPoints.push_back(corner2);
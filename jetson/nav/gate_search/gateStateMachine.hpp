@@ -15,7 +15,7 @@ public:
     /*************************************************************************/
     /* Public Member Functions */
     /*************************************************************************/
-    GateStateMachine( StateMachine* stateMachine, Rover* rover, const rapidjson::Document& roverConfig );
+    GateStateMachine( StateMachine* stateMachine, Rover* rover, const NavConfig& roverConfig );
 
     virtual ~GateStateMachine();
 
@@ -33,7 +33,7 @@ public:
     Waypoint lastKnownPost2;
 
     // Queue of search points
-    deque<Odometry> mGateSearchPoints;
+    deque<LocalPoint> mGateSearchPoints;
 
 private:
     /*************************************************************************/
@@ -68,11 +68,11 @@ private:
     StateMachine* mRoverStateMachine;
 
     // Reference to config variables
-    const rapidjson::Document& mRoverConfig;
+    const NavConfig& mRoverConfig;
 
     // Points in frnot of center of gate
-    Odometry centerPoint1;
-    Odometry centerPoint2;
+    LocalPoint centerPoint1;
+    LocalPoint centerPoint2;
 
     //
     bool CP1ToCP2CorrectDir;
@@ -85,6 +85,6 @@ protected:
     Rover* mRover;
 };
 
-GateStateMachine* GateFactory( StateMachine* stateMachine, Rover* rover, const rapidjson::Document& roverConfig );
+GateStateMachine* GateFactory( StateMachine* stateMachine, Rover* rover, const NavConfig& roverConfig );
 
 #endif //GATE_STATE_MACHINE_HPP
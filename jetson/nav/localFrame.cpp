@@ -0,0 +1,47 @@
+#include "localFrame.hpp"
+
+#include <cmath>
+
+// Meters per minute of latitude, everywhere.
+static const double METERS_PER_LAT_MINUTE = 6371000.0 * M_PI / ( 180 * 60 );
+
+// Splits a signed number of minutes into whole degrees and the
+// remaining minutes, which have the same sign as the degrees.
+static void splitMinutes( const double totalMinutes, int32_t& degrees, double& minutes )
+{
+    degrees = static_cast< int32_t >( totalMinutes / 60 );
+    minutes = totalMinutes - degrees * 60.0;
+} // splitMinutes()
+
+LocalFrame::LocalFrame()
+{
+    anchor( Odometry() );
+} // LocalFrame()
+
+void LocalFrame::anchor( const Odometry& origin )
+{
+    mOrigin = origin;
+    double latitude = ( origin.latitude_deg + origin.latitude_min / 60 ) * M_PI / 180;
+    mMetersPerLonMinute = METERS_PER_LAT_MINUTE * cos( latitude );
+} // anchor()
+
+// Differences are taken in minutes before scaling, so points near the
+// origin don't lose precision to the size of the whole coordinate.
+LocalPoint LocalFrame::toLocal( const Odometry& odometry ) const
+{
+    double latMinutes = ( odometry.latitude_deg - mOrigin.latitude_deg ) * 60.0 +
+                        ( odometry.latitude_min - mOrigin.latitude_min );
+    double lonMinutes = ( odometry.longitude_deg - mOrigin.longitude_deg ) * 60.0 +
+                        ( odometry.longitude_min - mOrigin.longitude_min );
+    return { lonMinutes * mMetersPerLonMinute, latMinutes * METERS_PER_LAT_MINUTE };
+} // toLocal()
+
+Odometry LocalFrame::toOdometry( const LocalPoint& point ) const
+{
+    Odometry odometry = Odometry();
+    splitMinutes( mOrigin.latitude_deg * 60.0 + mOrigin.latitude_min + point.north / METERS_PER_LAT_MINUTE,
+                  odometry.latitude_deg, odometry.latitude_min );
+    splitMinutes( mOrigin.longitude_deg * 60.0 + mOrigin.longitude_min + point.east / mMetersPerLonMinute,
+                  odometry.longitude_deg, odometry.longitude_min );
+    return odometry;
+} // toOdometry()
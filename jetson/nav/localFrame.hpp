@@ -0,0 +1,46 @@
+#ifndef LOCAL_FRAME_HPP
+#define LOCAL_FRAME_HPP
+
+#include "rover_msgs/Odometry.hpp"
+
+using namespace rover_msgs;
+
+// A point on the ground in meters east and north of a local frame's
+// origin.
+struct LocalPoint
+{
+    double east;
+    double north;
+};
+
+// A flat east-north-up frame touching the earth at an origin. Over the
+// few kilometers of a course the flat projection is off by far less
+// than gps noise, so once odometry is in this frame distances,
+// bearings and offsets are plain vector math instead of trigonometry
+// on degree and minute pairs. Converting in either direction costs a
+// couple of multiplications; the only trigonometry is the cosine
+// taken once when the frame is anchored.
+class LocalFrame
+{
+public:
+    // Anchors the frame at latitude and longitude zero.
+    LocalFrame();
+
+    // Moves the origin of the frame to origin.
+    void anchor( const Odometry& origin );
+
+    LocalPoint toLocal( const Odometry& odometry ) const;
+
+    // Converts point back to latitude and longitude. The bearing and
+    // speed of the result are zero.
+    Odometry toOdometry( const LocalPoint& point ) const;
+
+private:
+    // Latitude and longitude of the origin.
+    Odometry mOrigin;
+
+    // Meters per minute of longitude at the origin's latitude.
+    double mMetersPerLonMinute;
+};
+
+#endif // LOCAL_FRAME_HPP
@@ -1,4 +1,11 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <poll.h>
+#include <stdexcept>
 #include <lcm/lcm-cpp.hpp>
 #include "stateMachine.hpp"
 
@@ -91,6 +98,72 @@ private:
     StateMachine* mStateMachine;
 };
 
+// Runs the state machine at a fixed rate until LCM fails. Between ticks
+// every incoming message is handled as soon as it arrives, so each tick
+// sees the newest status no matter how many messages came in since the
+// last one, and wait states keep ticking when no messages arrive.
+// A tick that finishes after the next deadline has passed counts that
+// deadline as missed, and the schedule skips ahead instead of running
+// the missed ticks back to back.
+int runAtFixedRate( lcm::LCM& lcmObject, StateMachine& roverStateMachine, double rateHz )
+{
+    using Clock = chrono::steady_clock;
+    const Clock::duration period = chrono::duration_cast< Clock::duration >( chrono::duration< double >( 1.0 / rateHz ) );
+    const Clock::duration reportInterval = chrono::seconds( 60 );
+
+    pollfd lcmFd = { lcmObject.getFileno(), POLLIN, 0 };
+    Clock::time_point nextTick = Clock::now();
+    Clock::time_point nextReport = nextTick + reportInterval;
+    unsigned long ticks = 0;
+    unsigned long missedDeadlines = 0;
+    unsigned long reportedMisses = 0;
+
+    while( true )
+    {
+        Clock::time_point now = Clock::now();
+        if( now >= nextTick )
+        {
+            roverStateMachine.run();
+            ++ticks;
+            nextTick += period;
+
+            now = Clock::now();
+            if( now >= nextTick )
+            {
+                long missed = ( now - nextTick ) / period + 1;
+                missedDeadlines += missed;
+                nextTick += missed * period;
+            }
+            if( now >= nextReport )
+            {
+                if( missedDeadlines > reportedMisses )
+                {
+                    cerr << "Nav loop missed " << missedDeadlines << " of "
+                         << ticks + missedDeadlines << " deadlines\n";
+                    reportedMisses = missedDeadlines;
+                }
+                nextReport = now + reportInterval;
+            }
+            continue;
+        }
+
+        // Round up so poll doesn't wake just short of the deadline
+        long remainingUs = chrono::duration_cast< chrono::microseconds >( nextTick - now ).count();
+        int timeoutMs = ( remainingUs + 999 ) / 1000;
+        int ready = poll( &lcmFd, 1, timeoutMs );
+        if( ready < 0 && errno != EINTR )
+        {
+            cerr << "Error: poll on LCM failed: " << strerror( errno ) << "\n";
+            return 1;
+        }
+        if( ready > 0 && lcmObject.handleTimeout( 0 ) < 0 )
+        {
+            cerr << "Error: LCM failed to handle a message\n";
+            return 1;
+        }
+    }
+} // runAtFixedRate()
+
 // Runs the autonomous navigation of the rover.
 int main()
 {
@@ -101,7 +174,22 @@ int main()
         return 1;
     }
 
-    StateMachine roverStateMachine( lcmObject );
+    // A configuration that is missing a setting stops nav here instead
+    // of in the middle of a mission.
+    string configPath = getenv( "MROVER_CONFIG" );
+    configPath += "/config_nav/config.json";
+    unique_ptr< ConfigWatcher > configWatcher;
+    try
+    {
+        configWatcher.reset( new ConfigWatcher( configPath ) );
+    }
+    catch( const runtime_error& e )
+    {
+        cerr << "Error: " << configPath << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    StateMachine roverStateMachine( lcmObject, *configWatcher );
     LcmHandlers lcmHandlers( &roverStateMachine );
 
     lcmObject.subscribe( "/auton", &LcmHandlers::autonState, &lcmHandlers );
@@ -112,9 +200,5 @@ int main()
     lcmObject.subscribe( "/rr_drop_complete", &LcmHandlers::repeaterDropComplete, &lcmHandlers );
     lcmObject.subscribe( "/target_list", &LcmHandlers::targetList, &lcmHandlers );
 
-    while( lcmObject.handle() == 0 )
-    {
-        roverStateMachine.run();
-    }
-    return 0;
+    return runAtFixedRate( lcmObject, roverStateMachine, roverStateMachine.loopRate() );
 } // main()
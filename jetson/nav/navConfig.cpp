@@ -0,0 +1,225 @@
+#include "navConfig.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "rapidjson/document.h"
+
+// Returns the member name of section in root. Throws if either is
+// missing.
+static const rapidjson::Value& getSetting( const rapidjson::Value& root, const char* section, const char* name )
+{
+    if( !root.HasMember( section ) || !root[ section ].IsObject() )
+    {
+        throw runtime_error( string( section ) + " is missing" );
+    }
+    const rapidjson::Value& sectionValue = root[ section ];
+    if( !sectionValue.HasMember( name ) )
+    {
+        throw runtime_error( string( section ) + "/" + name + " is missing" );
+    }
+    return sectionValue[ name ];
+} // getSetting()
+
+static double getDouble( const rapidjson::Value& root, const char* section, const char* name )
+{
+    const rapidjson::Value& setting = getSetting( root, section, name );
+    if( !setting.IsNumber() )
+    {
+        throw runtime_error( string( section ) + "/" + name + " is not a number" );
+    }
+    return setting.GetDouble();
+} // getDouble()
+
+static int getInt( const rapidjson::Value& root, const char* section, const char* name )
+{
+    const rapidjson::Value& setting = getSetting( root, section, name );
+    if( !setting.IsInt() )
+    {
+        throw runtime_error( string( section ) + "/" + name + " is not an integer" );
+    }
+    return setting.GetInt();
+} // getInt()
+
+static string getString( const rapidjson::Value& root, const char* section, const char* name )
+{
+    const rapidjson::Value& setting = getSetting( root, section, name );
+    if( !setting.IsString() )
+    {
+        throw runtime_error( string( section ) + "/" + name + " is not a string" );
+    }
+    return setting.GetString();
+} // getString()
+
+static PidGains getPidGains( const rapidjson::Value& root, const char* section )
+{
+    PidGains gains = { getDouble( root, section, "kP" ),
+                       getDouble( root, section, "kI" ),
+                       getDouble( root, section, "kD" ),
+                       getDouble( root, section, "integralLimit" ),
+                       getDouble( root, section, "derivativeTimeConstant" ) };
+    if( gains.integralLimit < 0 || gains.derivativeTimeConstant < 0 )
+    {
+        throw runtime_error( string( section ) + "/integralLimit and derivativeTimeConstant can't be negative" );
+    }
+    return gains;
+} // getPidGains()
+
+NavConfig::NavConfig( const string& json )
+{
+    rapidjson::Document root;
+    root.Parse( json.c_str() );
+    if( root.HasParseError() || !root.IsObject() )
+    {
+        throw runtime_error( "not a valid JSON object (error at offset " +
+                             to_string( root.GetErrorOffset() ) + ")" );
+    }
+
+    bearingPid = getPidGains( root, "bearingPid" );
+    distancePid = getPidGains( root, "distancePid" );
+
+    joystick.bearingPower = getDouble( root, "joystick", "bearingPower" );
+    joystick.drivingPower = getDouble( root, "joystick", "drivingPower" );
+    joystick.dampen = getDouble( root, "joystick", "dampen" );
+
+    navLoop.rateHz = getDouble( root, "navLoop", "rateHz" );
+    if( navLoop.rateHz <= 0 )
+    {
+        throw runtime_error( "navLoop/rateHz must be positive" );
+    }
+
+    navThresholds.turningBearing = getDouble( root, "navThresholds", "turningBearing" );
+    navThresholds.drivingBearing = getDouble( root, "navThresholds", "drivingBearing" );
+    navThresholds.waypointDistance = getDouble( root, "navThresholds", "waypointDistance" );
+    navThresholds.targetDistance = getDouble( root, "navThresholds", "targetDistance" );
+    navThresholds.minTurningEffort = getDouble( root, "navThresholds", "minTurningEffort" );
+    navThresholds.gateCenteredAngleDiff = getDouble( root, "navThresholds", "gateCenteredAngleDiff" );
+    navThresholds.obstacleDistanceThreshold = getDouble( root, "navThresholds", "obstacleDistanceThreshold" );
+
+    roverMeasurements.width = getDouble( root, "roverMeasurements", "width" );
+
+    computerVision.visionDistance = getDouble( root, "computerVision", "visionDistance" );
+    computerVision.fieldOfViewAngle = getDouble( root, "computerVision", "fieldOfViewAngle" );
+    computerVision.fieldOfViewSafeAngle = getDouble( root, "computerVision", "fieldOfViewSafeAngle" );
+
+    lcmChannels.navStatusChannel = getString( root, "lcmChannels", "navStatusChannel" );
+    lcmChannels.repeaterDropInitChannel = getString( root, "lcmChannels", "repeaterDropInitChannel" );
+    lcmChannels.repeaterDropCompleteChannel = getString( root, "lcmChannels", "repeaterDropCompleteChannel" );
+    lcmChannels.joystickChannel = getString( root, "lcmChannels", "joystickChannel" );
+    lcmChannels.zedGimbalCommand = getString( root, "lcmChannels", "zedGimbalCommand" );
+    lcmChannels.zedGimbalPosition = getString( root, "lcmChannels", "zedGimbalPosition" );
+
+    radioRepeaterThresholds.signalStrengthCutOff = getDouble( root, "radioRepeaterThresholds", "signalStrengthCutOff" );
+    radioRepeaterThresholds.lowSignalWaitTime = getDouble( root, "radioRepeaterThresholds", "lowSignalWaitTime" );
+
+    const rapidjson::Value& order = getSetting( root, "search", "order" );
+    if( !order.IsArray() )
+    {
+        throw runtime_error( "search/order is not an array" );
+    }
+    for( rapidjson::SizeType i = 0; i < order.Size(); ++i )
+    {
+        if( !order[ i ].IsInt() )
+        {
+            throw runtime_error( "search/order has an entry that is not an integer" );
+        }
+        search.order.push_back( order[ i ].GetInt() );
+    }
+    search.numSearches = getInt( root, "search", "numSearches" );
+    if( search.numSearches < 1 || search.numSearches > static_cast< int >( search.order.size() ) )
+    {
+        throw runtime_error( "search/numSearches must be between 1 and the length of search/order" );
+    }
+    search.bailThresh = getDouble( root, "search", "bailThresh" );
+    search.searchWaitStepSize = getDouble( root, "search", "searchWaitStepSize" );
+    search.searchWaitTime = getDouble( root, "search", "searchWaitTime" );
+} // NavConfig()
+
+// Loads the configuration and starts watching it. Editors usually
+// save by writing a temporary file and renaming it over the old one,
+// which would orphan a watch on the file itself, so the directory is
+// watched instead.
+ConfigWatcher::ConfigWatcher( const string& path )
+    : mPath( path )
+    , mName( path.substr( path.find_last_of( '/' ) + 1 ) )
+    , mConfig( read() )
+    , mWatchFd( inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) )
+{
+    size_t slash = mPath.find_last_of( '/' );
+    string dir = slash == string::npos ? "." : mPath.substr( 0, slash );
+    if( mWatchFd < 0 || inotify_add_watch( mWatchFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) < 0 )
+    {
+        cerr << "Could not watch " << mPath << ", config will not reload\n";
+        if( mWatchFd >= 0 )
+        {
+            close( mWatchFd );
+        }
+        mWatchFd = -1;
+    }
+} // ConfigWatcher()
+
+ConfigWatcher::~ConfigWatcher()
+{
+    if( mWatchFd >= 0 )
+    {
+        close( mWatchFd );
+    }
+} // ~ConfigWatcher()
+
+const NavConfig& ConfigWatcher::current() const
+{
+    return mConfig;
+} // current()
+
+bool ConfigWatcher::update()
+{
+    if( mWatchFd < 0 )
+    {
+        return false;
+    }
+
+    alignas( inotify_event ) char buffer[ 4096 ];
+    bool changed = false;
+    ssize_t length;
+    while( ( length = ::read( mWatchFd, buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        for( char* event = buffer; event < buffer + length; )
+        {
+            const inotify_event* fileEvent = reinterpret_cast< const inotify_event* >( event );
+            changed = changed || ( fileEvent->len > 0 && mName == fileEvent->name );
+            event += sizeof( inotify_event ) + fileEvent->len;
+        }
+    }
+    if( !changed )
+    {
+        return false;
+    }
+
+    try
+    {
+        mConfig = NavConfig( read() );
+    }
+    catch( const runtime_error& e )
+    {
+        cerr << "Ignoring " << mPath << ": " << e.what() << "\n";
+        return false;
+    }
+    cout << "Reloaded " << mPath << "\n";
+    return true;
+} // update()
+
+string ConfigWatcher::read() const
+{
+    ifstream configFile( mPath );
+    if( !configFile )
+    {
+        throw runtime_error( "could not open " + mPath );
+    }
+    stringstream contents;
+    contents << configFile.rdbuf();
+    return contents.str();
+} // read()
@@ -0,0 +1,159 @@
+#ifndef NAV_CONFIG_HPP
+#define NAV_CONFIG_HPP
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Gains of one of the rover's pid loops. kI is per second of error
+// and kD per unit of error per second.
+struct PidGains
+{
+    double kP;
+    double kI;
+    double kD;
+
+    // Largest effort the integral term may add, 0 for no limit.
+    double integralLimit;
+
+    // Seconds of low pass filtering on the derivative term.
+    double derivativeTimeConstant;
+};
+
+// Scaling applied to every joystick command nav publishes.
+struct JoystickConfig
+{
+    double bearingPower;
+    double drivingPower;
+    double dampen;
+};
+
+// Timing of the nav loop.
+struct NavLoopConfig
+{
+    double rateHz;
+};
+
+// Distances (meters) and angles (degrees) at which nav considers a
+// movement done.
+struct NavThresholds
+{
+    double turningBearing;
+    double drivingBearing;
+    double waypointDistance;
+    double targetDistance;
+    double minTurningEffort;
+    double gateCenteredAngleDiff;
+    double obstacleDistanceThreshold;
+};
+
+// Physical dimensions of the rover (meters).
+struct RoverMeasurements
+{
+    double width;
+};
+
+// What the camera can see, in meters and degrees.
+struct ComputerVisionConfig
+{
+    double visionDistance;
+    double fieldOfViewAngle;
+    double fieldOfViewSafeAngle;
+};
+
+// Names of the lcm channels nav publishes on.
+struct LcmChannels
+{
+    string navStatusChannel;
+    string repeaterDropInitChannel;
+    string repeaterDropCompleteChannel;
+    string joystickChannel;
+    string zedGimbalCommand;
+    string zedGimbalPosition;
+};
+
+// When to drop a radio repeater.
+struct RadioRepeaterThresholds
+{
+    double signalStrengthCutOff;
+    double lowSignalWaitTime;
+};
+
+// Which searches to run and how.
+struct SearchConfig
+{
+    // Search types to cycle through, as numbered in ChangeSearchAlg.
+    vector< int > order;
+    int numSearches;
+    double bailThresh;
+    double searchWaitStepSize;
+    double searchWaitTime;
+};
+
+// The nav configuration file, parsed and checked once so the state
+// machines read plain members instead of looking up json on every
+// tick. Mirrors the sections and names of config.json.
+struct NavConfig
+{
+    // Parses json. Throws runtime_error naming the setting if json
+    // does not parse or any setting is missing, of the wrong type or
+    // out of range.
+    NavConfig( const string& json );
+
+    PidGains bearingPid;
+    PidGains distancePid;
+    JoystickConfig joystick;
+    NavLoopConfig navLoop;
+    NavThresholds navThresholds;
+    RoverMeasurements roverMeasurements;
+    ComputerVisionConfig computerVision;
+    LcmChannels lcmChannels;
+    RadioRepeaterThresholds radioRepeaterThresholds;
+    SearchConfig search;
+};
+
+// Owns the nav configuration and reloads it when the file is saved.
+// Everything that reads the configuration holds a reference to
+// current(), which only changes when update() is called, so a reload
+// can never land in the middle of a tick. A saved file that is not
+// a valid configuration is reported and ignored.
+class ConfigWatcher
+{
+public:
+    // Loads the configuration at path. Throws runtime_error if it
+    // can't be read or is not a valid configuration.
+    ConfigWatcher( const string& path );
+
+    ~ConfigWatcher();
+
+    ConfigWatcher( const ConfigWatcher& ) = delete;
+
+    ConfigWatcher& operator=( const ConfigWatcher& ) = delete;
+
+    const NavConfig& current() const;
+
+    // Reloads the configuration if the file was saved since the last
+    // call. Never blocks. Returns true if a new configuration was
+    // loaded.
+    bool update();
+
+private:
+    // Reads the whole file at mPath.
+    string read() const;
+
+    // Path of the configuration file.
+    string mPath;
+
+    // Name of the configuration file within its directory.
+    string mName;
+
+    // The configuration in use.
+    NavConfig mConfig;
+
+    // Inotify descriptor watching the configuration's directory, -1
+    // if the configuration can't be watched.
+    int mWatchFd;
+};
+
+#endif // NAV_CONFIG_HPP
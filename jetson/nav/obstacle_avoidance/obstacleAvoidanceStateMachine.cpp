@@ -7,7 +7,7 @@
 #include <iostream>
 
 // Constructs an ObstacleAvoidanceStateMachine object with roverStateMachine, mRoverConfig, and mRover
-ObstacleAvoidanceStateMachine::ObstacleAvoidanceStateMachine( StateMachine* stateMachine_, Rover* rover, const rapidjson::Document& roverConfig )
+ObstacleAvoidanceStateMachine::ObstacleAvoidanceStateMachine( StateMachine* stateMachine_, Rover* rover, const NavConfig& roverConfig )
     : roverStateMachine( stateMachine_ )
     , mJustDetectedObstacle( false )
     , mRover( rover ) 
@@ -74,7 +74,7 @@ bool ObstacleAvoidanceStateMachine::isTargetDetected ()
 // The obstacle avoidance factory allows for the creation of obstacle avoidance objects and
 // an ease of transition between obstacle avoidance algorithms
 ObstacleAvoidanceStateMachine* ObstacleAvoiderFactory ( StateMachine* roverStateMachine,
-                                                        ObstacleAvoidanceAlgorithm algorithm, Rover* rover, const rapidjson::Document& roverConfig )
+                                                        ObstacleAvoidanceAlgorithm algorithm, Rover* rover, const NavConfig& roverConfig )
 {
     ObstacleAvoidanceStateMachine* avoid = nullptr;
     switch ( algorithm )
@@ -19,7 +19,7 @@ public:
     /*************************************************************************/
     /* Public Member Functions */
     /*************************************************************************/
-    ObstacleAvoidanceStateMachine( StateMachine* stateMachine_, Rover* rover, const rapidjson::Document& roverConfig );
+    ObstacleAvoidanceStateMachine( StateMachine* stateMachine_, Rover* rover, const NavConfig& roverConfig );
 
     virtual ~ObstacleAvoidanceStateMachine() {}
 
@@ -33,12 +33,12 @@ public:
 
     bool isTargetDetected();
 
-    virtual Odometry createAvoidancePoint( Rover* rover, const double distance ) = 0;
+    virtual LocalPoint createAvoidancePoint( Rover* rover, const double distance ) = 0;
 
-    virtual NavState executeTurnAroundObs( Rover* rover, const rapidjson::Document& roverConfig ) = 0;
+    virtual NavState executeTurnAroundObs( Rover* rover, const NavConfig& roverConfig ) = 0;
 
 
-    virtual NavState executeDriveAroundObs( Rover* rover, const rapidjson::Document& roverConfig ) = 0;
+    virtual NavState executeDriveAroundObs( Rover* rover, const NavConfig& roverConfig ) = 0;
 
 
 protected:
@@ -50,7 +50,7 @@ protected:
     StateMachine* roverStateMachine;
 
     // Odometry point used when avoiding obstacles.
-    Odometry mObstacleAvoidancePoint;
+    LocalPoint mObstacleAvoidancePoint;
 
     // Initial angle to go around obstacle upon detection.
     double mOriginalObstacleAngle;
@@ -73,7 +73,7 @@ private:
     /*************************************************************************/
 
     // Reference to config variables
-    const rapidjson::Document& mRoverConfig;
+    const NavConfig& mRoverConfig;
 
 };
 
@@ -81,6 +81,6 @@ private:
 // avoidance algorithm. This allows for an an ease of transition between obstacle 
 // avoidance algorithms
 ObstacleAvoidanceStateMachine* ObstacleAvoiderFactory( StateMachine* roverStateMachine,
-                                                       ObstacleAvoidanceAlgorithm algorithm, Rover* rover, const rapidjson::Document& roverConfig );
+                                                       ObstacleAvoidanceAlgorithm algorithm, Rover* rover, const NavConfig& roverConfig );
 
 #endif //OBSTACLE_AVOIDANCE_STATE_MACHINE_HPP
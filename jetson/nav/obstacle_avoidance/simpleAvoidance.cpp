@@ -10,7 +10,7 @@
 // SimpleAvoidance is abstacted from ObstacleAvoidanceStateMachine object so it creates an
 // ObstacleAvoidanceStateMachine object with the roverStateMachine, rover, and roverConfig. 
 // The SimpleAvoidance object will execute the logic for the simple avoidance algorithm
-SimpleAvoidance::SimpleAvoidance( StateMachine* roverStateMachine, Rover* rover, const rapidjson::Document& roverConfig )
+SimpleAvoidance::SimpleAvoidance( StateMachine* roverStateMachine, Rover* rover, const NavConfig& roverConfig )
     : ObstacleAvoidanceStateMachine( roverStateMachine, rover, roverConfig ) {}
 
 // Destructs the SimpleAvoidance object.
@@ -20,7 +20,7 @@ SimpleAvoidance::~SimpleAvoidance() {}
 // If in search state and target is both detected and reachable, return NavState TurnToTarget.
 // ASSUMPTION: There is no rock that is more than 8 meters (pathWidth * 2) in diameter
 NavState SimpleAvoidance::executeTurnAroundObs( Rover* rover,
-                                                const rapidjson::Document& roverConfig )
+                                                const NavConfig& roverConfig )
 {
     if( isTargetDetected () && isTargetReachable( rover, roverConfig ) )
     {
@@ -54,7 +54,7 @@ NavState SimpleAvoidance::executeTurnAroundObs( Rover* rover,
 
 // Drives to dummy waypoint. Once arrived, rover will drive to original waypoint
 // ( original waypoint is the waypoint before obstacle avoidance was triggered )
-NavState SimpleAvoidance::executeDriveAroundObs( Rover* rover, const rapidjson::Document& roverConfig )
+NavState SimpleAvoidance::executeDriveAroundObs( Rover* rover, const NavConfig& roverConfig )
 {
     if( isObstacleDetected( rover )  && isObstacleInThreshold( rover, roverConfig ) )
 
@@ -87,18 +87,8 @@ NavState SimpleAvoidance::executeDriveAroundObs( Rover* rover, const rapidjson::
 } // executeDriveAroundObs()
 
 // Create the odometry point used to drive around an obstacle
-Odometry SimpleAvoidance::createAvoidancePoint( Rover* rover, const double distance )
+LocalPoint SimpleAvoidance::createAvoidancePoint( Rover* rover, const double distance )
 {
-    Odometry avoidancePoint = rover->roverStatus().odometry();
-    double totalLatitudeMinutes = avoidancePoint.latitude_min +
-        cos( degreeToRadian( avoidancePoint.bearing_deg ) ) * distance * LAT_METER_IN_MINUTES;
-    double totalLongitudeMinutes = avoidancePoint.longitude_min +
-        sin( degreeToRadian( avoidancePoint.bearing_deg ) ) * distance * rover->longMeterInMinutes();
-    avoidancePoint.latitude_deg += totalLatitudeMinutes / 60;
-    avoidancePoint.latitude_min = ( totalLatitudeMinutes - ( ( (int) totalLatitudeMinutes) / 60 ) * 60 );
-    avoidancePoint.longitude_deg += totalLongitudeMinutes / 60;
-    avoidancePoint.longitude_min = ( totalLongitudeMinutes - ( ( (int) totalLongitudeMinutes) / 60 ) * 60 );
-
-    return avoidancePoint;
+    return createPoint( rover->position(), rover->roverStatus().odometry().bearing_deg, distance );
 
 } // createAvoidancePoint()
@@ -1,24 +1,72 @@
 #include "pid.hpp"
 
+#include <cmath>
+
 PidLoop::PidLoop(double Kp, double Ki, double Kd) :
     Kp_(Kp),
     Ki_(Ki),
     Kd_(Kd),
+    integral_limit_(0.0),
+    derivative_time_constant_(0.0),
+    modulus_(0.0),
     first_(true),
     accumulated_error_(0.0),
-    last_error_(0.0)
+    last_error_(0.0),
+    derivative_(0.0)
 {
 }
 
+void PidLoop::setGains(double Kp, double Ki, double Kd) {
+    Kp_ = Kp;
+    Ki_ = Ki;
+    Kd_ = Kd;
+}
+
+void PidLoop::setIntegralLimit(double limit) {
+    integral_limit_ = limit;
+}
+
+void PidLoop::setDerivativeTimeConstant(double seconds) {
+    derivative_time_constant_ = seconds;
+}
+
+void PidLoop::setModulus(double modulus) {
+    modulus_ = modulus;
+}
+
 double PidLoop::update(double current, double desired) {
+    return this->update(current, desired, Clock::now());
+}
+
+double PidLoop::update(double current, double desired, Clock::time_point now) {
     double err = this->error(current, desired);
-    accumulated_error_ += err;
-    double effort = Kp_*err + Ki_*accumulated_error_;
+
+    // The first update after a reset has no time step, so it is
+    // proportional only. Updates at the same instant reuse the last
+    // integral and derivative.
     if (!first_) {
-        effort += Kd_*(err - last_error_);
+        double dt = std::chrono::duration<double>(now - last_time_).count();
+        if (dt > 0) {
+            accumulated_error_ += err * dt;
+            if (integral_limit_ > 0 && Ki_ != 0) {
+                double max_accumulated = integral_limit_ / std::fabs(Ki_);
+                accumulated_error_ = std::fmax(-max_accumulated, std::fmin(accumulated_error_, max_accumulated));
+            }
+
+            double raw_derivative = this->wrap(err - last_error_) / dt;
+            derivative_ += dt / (derivative_time_constant_ + dt) * (raw_derivative - derivative_);
+
+            last_time_ = now;
+            last_error_ = err;
+        }
     }
-    last_error_ = err;
-    first_ = false;
+    else {
+        last_time_ = now;
+        last_error_ = err;
+        first_ = false;
+    }
+
+    double effort = Kp_*err + Ki_*accumulated_error_ + Kd_*derivative_;
 
     if (effort < sat_min_out_) effort = sat_min_out_;
     if (effort > sat_max_out_) effort = sat_max_out_;
@@ -30,9 +78,16 @@ void PidLoop::reset() {
     first_ = true;
     accumulated_error_ = 0.0;
     last_error_ = 0.0;
+    derivative_ = 0.0;
 }
 
 double PidLoop::error(double current, double desired) {
-    // TODO add support for modular PID here
-    return desired - current;
+    return this->wrap(desired - current);
+}
+
+double PidLoop::wrap(double value) {
+    if (modulus_ <= 0) return value;
+    double wrapped = std::fmod(value + modulus_ / 2, modulus_);
+    if (wrapped < 0) wrapped += modulus_;
+    return wrapped - modulus_ / 2;
 }
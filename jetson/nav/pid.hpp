@@ -1,23 +1,56 @@
 #pragma once
 
+#include <chrono>
+
+// Gains are per second, so the loop behaves the same no matter how
+// often update is called: Ki scales the integral of the error over
+// time and Kd the error's rate of change per second.
 class PidLoop {
     public:
+        using Clock = std::chrono::steady_clock;
+
         PidLoop(double Kp, double Ki, double Kd);
 
+        void setGains(double Kp, double Ki, double Kd);
+
+        // Largest magnitude the integral term may add to the effort,
+        // the integral stops growing once it is reached. 0 for no limit.
+        void setIntegralLimit(double limit);
+
+        // Time constant in seconds of the low pass filter on the
+        // derivative term. 0 for no filtering.
+        void setDerivativeTimeConstant(double seconds);
+
+        // Errors are wrapped into [-modulus / 2, modulus / 2), so with
+        // 360 the loop always turns the short way around. 0 for none.
+        void setModulus(double modulus);
+
         double update(double current, double desired);
+
+        // now must not go backwards between calls.
+        double update(double current, double desired, Clock::time_point now);
+
         void reset();
 
     private:
         double error(double current, double desired);
 
+        double wrap(double value);
+
         double Kp_;
         double Ki_;
         double Kd_;
 
+        double integral_limit_;
+        double derivative_time_constant_;
+        double modulus_;
+
         const double sat_min_out_ = -1.0;
         const double sat_max_out_ = +1.0;
 
         bool first_;
+        Clock::time_point last_time_;
         double accumulated_error_;
         double last_error_;
+        double derivative_;
 };
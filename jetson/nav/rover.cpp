@@ -68,50 +68,52 @@ unsigned Rover::RoverStatus::getPathTargets()
   return mPathTargets;
 } // getPathTargets()
 
-// Assignment operator for the rover status object. Does a "deep" copy
-// where necessary.
-Rover::RoverStatus& Rover::RoverStatus::operator=( Rover::RoverStatus& newRoverStatus )
+// Rebuilds the path from the course, so the rover starts over at
+// the course's first waypoint.
+void Rover::RoverStatus::resetPath()
 {
-    mAutonState = newRoverStatus.autonState();
-    mCourse = newRoverStatus.course();
+    mPath.assign( mCourse.waypoints.begin(), mCourse.waypoints.begin() + mCourse.num_waypoints );
     mPathTargets = 0;
-
-    while( !mPath.empty() )
-    {
-        mPath.pop_front();
-    }
-    for( int courseIndex = 0; courseIndex < mCourse.num_waypoints; ++courseIndex )
+    for( const Waypoint& waypoint : mPath )
     {
-        auto &wp = mCourse.waypoints[ courseIndex ];
-        mPath.push_back( wp );
-        if (wp.search) {
+        if( waypoint.search )
+        {
             ++mPathTargets;
         }
     }
-    mObstacle = newRoverStatus.obstacle();
-    mOdometry = newRoverStatus.odometry();
-    mTarget1 = newRoverStatus.target();
-    mTarget2 = newRoverStatus.target2();
-    mSignal = newRoverStatus.radio();
-    return *this;
-} // operator=
+} // resetPath()
 
 // Constructs a rover object with the given configuration file and lcm
 // object with which to use for communications.
-Rover::Rover( const rapidjson::Document& config, lcm::LCM& lcmObject )
+Rover::Rover( const NavConfig& config, lcm::LCM& lcmObject )
     : mRoverConfig( config )
     , mLcmObject( lcmObject )
-    , mDistancePid( config[ "distancePid" ][ "kP" ].GetDouble(),
-                    config[ "distancePid" ][ "kI" ].GetDouble(),
-                    config[ "distancePid" ][ "kD" ].GetDouble() )
-    , mBearingPid( config[ "bearingPid" ][ "kP" ].GetDouble(),
-                   config[ "bearingPid" ][ "kI" ].GetDouble(),
-                   config[ "bearingPid" ][ "kD" ].GetDouble() )
+    , mDistancePid( config.distancePid.kP, config.distancePid.kI, config.distancePid.kD )
+    , mBearingPid( config.bearingPid.kP, config.bearingPid.kI, config.bearingPid.kD )
     , mTimeToDropRepeater( false )
-    , mLongMeterInMinutes( -1 )
+    , mFrameAnchored( false )
 {
+    // Bearings wrap around, so the bearing loop turns the short way
+    mBearingPid.setModulus( 360 );
+    reloadConfig();
 } // Rover()
 
+// Picks up the pid gains after the configuration was reloaded. Every
+// other setting is read from the configuration each time it is used.
+void Rover::reloadConfig()
+{
+    configurePid( mDistancePid, mRoverConfig.distancePid );
+    configurePid( mBearingPid, mRoverConfig.bearingPid );
+} // reloadConfig()
+
+// Sets the gains and limits of pid from the configuration.
+void Rover::configurePid( PidLoop& pid, const PidGains& gains )
+{
+    pid.setGains( gains.kP, gains.kI, gains.kD );
+    pid.setIntegralLimit( gains.integralLimit );
+    pid.setDerivativeTimeConstant( gains.derivativeTimeConstant );
+} // configurePid()
+
 // Sends a joystick command to drive forward from the current odometry
 // to the destination odometry. This joystick command will also turn
 // the rover small amounts as "course corrections".
@@ -119,8 +121,16 @@ Rover::Rover( const rapidjson::Document& config, lcm::LCM& lcmObject )
 // on-course or off-course.
 DriveStatus Rover::drive( const Odometry& destination )
 {
-    double distance = estimateNoneuclid( mRoverStatus.odometry(), destination );
-    double bearing = calcBearing( mRoverStatus.odometry(), destination );
+    return drive( mFrame.toLocal( destination ) );
+} // drive()
+
+// Sends a joystick command to drive forward from the current position
+// to the destination point in the rover's local frame.
+DriveStatus Rover::drive( const LocalPoint& destination )
+{
+    LocalPoint current = position();
+    double distance = calcDistance( current, destination );
+    double bearing = calcBearing( current, destination );
     return drive( distance, bearing, false );
 } // drive()
 
@@ -134,8 +144,8 @@ DriveStatus Rover::drive( const Odometry& destination )
 // on-course or off-course.
 DriveStatus Rover::drive( const double distance, const double bearing, const bool target )
 {
-    if( (!target && distance < mRoverConfig[ "navThresholds" ][ "waypointDistance" ].GetDouble()) ||
-        (target && distance < mRoverConfig[ "navThresholds" ][ "targetDistance" ].GetDouble()) )
+    if( (!target && distance < mRoverConfig.navThresholds.waypointDistance) ||
+        (target && distance < mRoverConfig.navThresholds.targetDistance) )
     {
         return DriveStatus::Arrived;
     }
@@ -143,7 +153,7 @@ DriveStatus Rover::drive( const double distance, const double bearing, const boo
     double destinationBearing = mod( bearing, 360 );
     throughZero( destinationBearing, mRoverStatus.odometry().bearing_deg ); // will go off course if inside if because through zero not calculated
 
-    if( fabs( destinationBearing - mRoverStatus.odometry().bearing_deg ) < mRoverConfig[ "navThresholds" ][ "drivingBearing" ].GetDouble() )
+    if( fabs( destinationBearing - mRoverStatus.odometry().bearing_deg ) < mRoverConfig.navThresholds.drivingBearing )
     {
         double distanceEffort = mDistancePid.update( -1 * distance, 0 );
         double turningEffort = mBearingPid.update( mRoverStatus.odometry().bearing_deg, destinationBearing );
@@ -171,9 +181,17 @@ void Rover::drive(const int direction, const double bearing)
 // Sends a joystick command to turn the rover toward the destination
 // odometry. Returns true if the rover has finished turning, false
 // otherwise.
-bool Rover::turn( Odometry& destination )
+bool Rover::turn( const Odometry& destination )
+{
+    return turn( mFrame.toLocal( destination ) );
+} // turn()
+
+// Sends a joystick command to turn the rover toward the destination
+// point in the rover's local frame. Returns true if the rover has
+// finished turning, false otherwise.
+bool Rover::turn( const LocalPoint& destination )
 {
-    double bearing = calcBearing( mRoverStatus.odometry(), destination );
+    double bearing = calcBearing( position(), destination );
     return turn( bearing );
 } // turn()
 
@@ -191,14 +209,14 @@ bool Rover::turn( double bearing )
     }
     else
     {
-        turningBearingThreshold = mRoverConfig[ "navThresholds" ][ "turningBearing" ].GetDouble();
+        turningBearingThreshold = mRoverConfig.navThresholds.turningBearing;
     }
     if( fabs( bearing - mRoverStatus.odometry().bearing_deg ) <= turningBearingThreshold )
     {
         return true;
     }
     double turningEffort = mBearingPid.update( mRoverStatus.odometry().bearing_deg, bearing );
-    double minTurningEffort = mRoverConfig[ "navThresholds" ][ "minTurningEffort" ].GetDouble() * (turningEffort < 0 ? -1 : 1);
+    double minTurningEffort = mRoverConfig.navThresholds.minTurningEffort * (turningEffort < 0 ? -1 : 1);
     if( isTurningAroundObstacle( mRoverStatus.currentState() ) && fabs(turningEffort) < minTurningEffort )
     {
         turningEffort = minTurningEffort;
@@ -213,33 +231,49 @@ void Rover::stop()
     publishJoystick( 0, 0, false );
 } // stop()
 
+// Copies incoming into current if it was written since appliedVersion
+// and records the version that was copied.
+template< typename T >
+static void applyIfNewer( const Versioned< T >& incoming, T& current, unsigned& appliedVersion )
+{
+    if( incoming.version() != appliedVersion )
+    {
+        current = incoming.value();
+        appliedVersion = incoming.version();
+    }
+} // applyIfNewer()
+
 // Checks if the rover should be updated based on what information in
-// the rover's status has changed. Returns true if the rover was
-// updated, false otherwise.
+// the incoming status has changed. Only fields written since the last
+// call are compared or copied, and the path is only rebuilt when the
+// rover is turned on. Returns true if the rover was updated, false
+// otherwise.
 // TODO: unconditionally update everygthing. When abstracting search class
 // we got rid of NavStates TurnToTarget and DriveToTarget (oops) fix this soon :P
-bool Rover::updateRover( RoverStatus newRoverStatus )
+bool Rover::updateRover( const IncomingStatus& incoming )
 {
     // Rover currently on.
     if( mRoverStatus.autonState().is_auton )
     {
         // Rover turned off
-        if( !newRoverStatus.autonState().is_auton )
+        if( !incoming.autonState.value().is_auton )
         {
-            mRoverStatus.autonState() = newRoverStatus.autonState();
+            applyIfNewer( incoming.autonState, mRoverStatus.autonState(), mApplied.autonState );
             return true;
         }
 
         // If any data has changed, update all data
-        if( !isEqual( mRoverStatus.obstacle(), newRoverStatus.obstacle() ) ||
-            !isEqual( mRoverStatus.odometry(), newRoverStatus.odometry() ) ||
-            !isEqual( mRoverStatus.target(), newRoverStatus.target()) ||
-            !isEqual( mRoverStatus.target2(), newRoverStatus.target2()) )
+        if( isChanged( incoming.obstacle, mApplied.obstacle, mRoverStatus.obstacle() ) ||
+            isChanged( incoming.odometry, mApplied.odometry, mRoverStatus.odometry() ) ||
+            isChanged( incoming.target, mApplied.target, mRoverStatus.target() ) ||
+            isChanged( incoming.target2, mApplied.target2, mRoverStatus.target2() ) )
         {
-            mRoverStatus.obstacle() = newRoverStatus.obstacle();
-            mRoverStatus.odometry() = newRoverStatus.odometry();
-            mRoverStatus.target() = newRoverStatus.target();
-            mRoverStatus.radio() = newRoverStatus.radio();
+            applyIfNewer( incoming.obstacle, mRoverStatus.obstacle(), mApplied.obstacle );
+            applyIfNewer( incoming.odometry, mRoverStatus.odometry(), mApplied.odometry );
+            applyIfNewer( incoming.target, mRoverStatus.target(), mApplied.target );
+            applyIfNewer( incoming.target2, mRoverStatus.target2(), mApplied.target2 );
+            applyIfNewer( incoming.radio, mRoverStatus.radio(), mApplied.radio );
+            anchorFrame();
             updateRepeater(mRoverStatus.radio());
             return true;
         }
@@ -251,24 +285,49 @@ bool Rover::updateRover( RoverStatus newRoverStatus )
     else
     {
         // Rover turned on.
-        if( newRoverStatus.autonState().is_auton )
+        if( incoming.autonState.value().is_auton )
         {
-            mRoverStatus = newRoverStatus;
-            // Calculate longitude minutes/meter conversion.
-            mLongMeterInMinutes = 60 / ( EARTH_CIRCUM * cos( degreeToRadian(
-                mRoverStatus.odometry().latitude_deg, mRoverStatus.odometry().latitude_min ) ) / 360 );
+            applyIfNewer( incoming.autonState, mRoverStatus.autonState(), mApplied.autonState );
+            applyIfNewer( incoming.course, mRoverStatus.course(), mApplied.course );
+            applyIfNewer( incoming.obstacle, mRoverStatus.obstacle(), mApplied.obstacle );
+            applyIfNewer( incoming.odometry, mRoverStatus.odometry(), mApplied.odometry );
+            applyIfNewer( incoming.target, mRoverStatus.target(), mApplied.target );
+            applyIfNewer( incoming.target2, mRoverStatus.target2(), mApplied.target2 );
+            applyIfNewer( incoming.radio, mRoverStatus.radio(), mApplied.radio );
+            mRoverStatus.resetPath();
+            mFrameAnchored = false;
+            anchorFrame();
             return true;
         }
         return false;
     }
 } // updateRover()
 
-// Calculates the conversion from minutes to meters based on the
-// rover's current latitude.
-const double Rover::longMeterInMinutes() const
+// Anchors the frame at the rover's odometry if it hasn't been since
+// the rover was turned on. Odometry that never arrived is all zeros,
+// and a frame anchored there would scale every east distance by the
+// equator's meters per minute, so anchoring waits for the first
+// odometry message.
+void Rover::anchorFrame()
 {
-    return mLongMeterInMinutes;
-}
+    if( !mFrameAnchored && mApplied.odometry != 0 )
+    {
+        mFrame.anchor( mRoverStatus.odometry() );
+        mFrameAnchored = true;
+    }
+} // anchorFrame()
+
+// Gets the rover's local frame.
+const LocalFrame& Rover::frame() const
+{
+    return mFrame;
+} // frame()
+
+// Gets the rover's current position in its local frame.
+LocalPoint Rover::position()
+{
+    return mFrame.toLocal( mRoverStatus.odometry() );
+} // position()
 
 // Executes the logic starting the clock to time how long it's been
 // since the rover has gotten a strong radio signal. If the signal drops
@@ -284,13 +343,13 @@ void Rover::updateRepeater(RadioSignalStrength& radioSignal)
     if( !mTimeToDropRepeater &&
         !started &&
         radioSignal.signal_strength <=
-        mRoverConfig[ "radioRepeaterThresholds" ][ "signalStrengthCutOff" ].GetDouble())
+        mRoverConfig.radioRepeaterThresholds.signalStrengthCutOff)
     {
         startTime = time( nullptr );
         started = true;
     }
 
-    double waitTime = mRoverConfig[ "radioRepeaterThresholds" ][ "lowSignalWaitTime" ].GetDouble();
+    double waitTime = mRoverConfig.radioRepeaterThresholds.lowSignalWaitTime;
     if( started && difftime( time( nullptr ), startTime ) > waitTime )
     {
         started = false;
@@ -328,14 +387,13 @@ void Rover::publishJoystick( const double forwardBack, const double leftRight, c
 {
     Joystick joystick;
     // power limit (0 = 50%, 1 = 0%, -1 = 100% power)
-    joystick.dampen = mRoverConfig[ "joystick" ][ "dampen" ].GetDouble();
-    double drivingPower = mRoverConfig[ "joystick" ][ "drivingPower" ].GetDouble();
+    joystick.dampen = mRoverConfig.joystick.dampen;
+    double drivingPower = mRoverConfig.joystick.drivingPower;
     joystick.forward_back = drivingPower * forwardBack;
-    double bearingPower = mRoverConfig[ "joystick" ][ "bearingPower" ].GetDouble();
+    double bearingPower = mRoverConfig.joystick.bearingPower;
     joystick.left_right = bearingPower * leftRight;
     joystick.kill = kill;
-    string joystickChannel = mRoverConfig[ "lcmChannels" ][ "joystickChannel" ].GetString();
-    mLcmObject.publish( joystickChannel, &joystick );
+    mLcmObject.publish( mRoverConfig.lcmChannels.joystickChannel, &joystick );
 } // publishJoystick()
 
 // Returns true if the two obstacle messages are equal, false
@@ -377,6 +435,14 @@ bool Rover::isEqual( const Target& target1, const Target& target2 ) const
     return false;
 } // isEqual( Target )
 
+// Returns true if incoming was written since appliedVersion and is not
+// equal to current, false otherwise.
+template< typename T >
+bool Rover::isChanged( const Versioned< T >& incoming, const unsigned appliedVersion, const T& current ) const
+{
+    return incoming.version() != appliedVersion && !isEqual( incoming.value(), current );
+} // isChanged()
+
 // Return true if the current state is TurnAroundObs or SearchTurnAroundObs,
 // false otherwise.
 bool Rover::isTurningAroundObstacle( const NavState currentState ) const
@@ -13,7 +13,8 @@
 #include "rover_msgs/RadioSignalStrength.hpp"
 #include "rover_msgs/TargetList.hpp"
 #include "rover_msgs/Waypoint.hpp"
-#include "rapidjson/document.h"
+#include "localFrame.hpp"
+#include "navConfig.hpp"
 #include "pid.hpp"
 
 using namespace rover_msgs;
@@ -78,6 +79,41 @@ enum class DriveStatus
     OffCourse
 }; // DriveStatus
 
+// A piece of the rover's status as it arrives over lcm. The version
+// counts every write, so a reader can tell if the value changed since
+// it last looked without comparing or copying it.
+template< typename T >
+class Versioned
+{
+public:
+    // Value initialized, so an auton state starts off.
+    Versioned()
+        : mValue()
+        , mVersion( 0 )
+    {}
+
+    const T& value() const
+    {
+        return mValue;
+    }
+
+    unsigned version() const
+    {
+        return mVersion;
+    }
+
+    void set( const T& value )
+    {
+        mValue = value;
+        ++mVersion;
+    }
+
+private:
+    T mValue;
+
+    unsigned mVersion;
+}; // Versioned
+
 // This class creates a Rover object which can perform operations that
 // the real rover can perform.
 class Rover
@@ -121,7 +157,7 @@ public:
 
         unsigned getPathTargets();
 
-        RoverStatus& operator=( RoverStatus& newRoverStatus );
+        void resetPath();
 
     private:
         // The rover's current navigation state.
@@ -158,21 +194,48 @@ public:
         unsigned mPathTargets;
     };
 
-    Rover( const rapidjson::Document& config, lcm::LCM& lcm_in );
+    // The newest status information received over lcm. The lcm
+    // handlers write each field as its message arrives and updateRover
+    // copies the fields written since its last call into the rover's
+    // status, so a message only ever copies its own field.
+    struct IncomingStatus
+    {
+        Versioned< AutonState > autonState;
+
+        Versioned< Course > course;
+
+        Versioned< Obstacle > obstacle;
+
+        Versioned< Odometry > odometry;
+
+        Versioned< Target > target;
+
+        Versioned< Target > target2;
+
+        Versioned< RadioSignalStrength > radio;
+    };
+
+    Rover( const NavConfig& config, lcm::LCM& lcm_in );
+
+    void reloadConfig();
 
     DriveStatus drive( const Odometry& destination );
 
+    DriveStatus drive( const LocalPoint& destination );
+
     DriveStatus drive( const double distance, const double bearing, const bool target = false );
 
     void drive(const int direction, const double bearing);
 
-    bool turn( Odometry& destination );
+    bool turn( const Odometry& destination );
+
+    bool turn( const LocalPoint& destination );
 
     bool turn( double bearing );
 
     void stop();
 
-    bool updateRover( RoverStatus newRoverStatus );
+    bool updateRover( const IncomingStatus& incoming );
 
     RoverStatus& roverStatus();
 
@@ -180,7 +243,9 @@ public:
 
     PidLoop& bearingPid();
 
-    const double longMeterInMinutes() const;
+    const LocalFrame& frame() const;
+
+    LocalPoint position();
 
     void updateRepeater( RadioSignalStrength& signal);
 
@@ -192,6 +257,10 @@ private:
     /*************************************************************************/
     void publishJoystick( const double forwardBack, const double leftRight, const bool kill );
 
+    void configurePid( PidLoop& pid, const PidGains& gains );
+
+    void anchorFrame();
+
     bool isEqual( const Obstacle& obstacle1, const Obstacle& obstacle2 ) const;
 
     bool isEqual( const Odometry& odometry1, const Odometry& odometry2 ) const;
@@ -200,6 +269,9 @@ private:
 
     bool isTurningAroundObstacle( const NavState currentState ) const;
 
+    template< typename T >
+    bool isChanged( const Versioned< T >& incoming, const unsigned appliedVersion, const T& current ) const;
+
     /*************************************************************************/
     /* Private Member Variables */
     /*************************************************************************/
@@ -207,8 +279,21 @@ private:
     // The rover's current status.
     RoverStatus mRoverStatus;
 
-    // A reference to the configuration file.
-    const rapidjson::Document& mRoverConfig;
+    // The versions of the incoming status fields that were last copied
+    // into mRoverStatus.
+    struct AppliedVersions
+    {
+        unsigned autonState = 0;
+        unsigned course = 0;
+        unsigned obstacle = 0;
+        unsigned odometry = 0;
+        unsigned target = 0;
+        unsigned target2 = 0;
+        unsigned radio = 0;
+    } mApplied;
+
+    // A reference to the configuration, owned by the config watcher.
+    const NavConfig& mRoverConfig;
 
     // A reference to the lcm object that will be used for
     // communicating with the actual rover and the base station.
@@ -223,9 +308,13 @@ private:
     // If it is time to drop a radio repeater
     bool mTimeToDropRepeater;
 
-    // The conversion factor from arcminutes to meters. This is based
-    // on the rover's current latitude.
-    double mLongMeterInMinutes;
+    // Flat frame anchored where the rover was turned on, which all
+    // distances, bearings and search patterns are computed in.
+    LocalFrame mFrame;
+
+    // If mFrame has been anchored at odometry received since the rover
+    // was turned on.
+    bool mFrameAnchored;
 };
 
 #endif // ROVER_HPP
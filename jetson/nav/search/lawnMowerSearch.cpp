@@ -7,11 +7,12 @@
 
 LawnMower::~LawnMower() {}
 
-void LawnMower::initializeSearch( Rover* rover, const rapidjson::Document& roverConfig, const double visionDistance )
+void LawnMower::initializeSearch( Rover* rover, const NavConfig& roverConfig, const double visionDistance )
 {
-    const double searchBailThresh = roverConfig[ "search" ][ "bailThresh" ].GetDouble();
+    const double searchBailThresh = roverConfig.search.bailThresh;
 
     mSearchPoints.clear();
+    const LocalPoint start = rover->position();
 
     mSearchPointMultipliers.clear();
     // mSearchPointMultipliers.push_back( pair<short, short> (  0, 0 ) );
@@ -25,17 +26,8 @@ void LawnMower::initializeSearch( Rover* rover, const rapidjson::Document& rover
     {
         for( auto& mSearchPointMultiplier : mSearchPointMultipliers )
         {
-            Odometry nextSearchPoint = rover->roverStatus().odometry();
-
-            double totalLatitudeMinutes = nextSearchPoint.latitude_min +
-                ( mSearchPointMultiplier.first * visionDistance  * LAT_METER_IN_MINUTES );
-            double totalLongitudeMinutes = nextSearchPoint.longitude_min +
-                ( mSearchPointMultiplier.second * (2 * searchBailThresh) * rover->longMeterInMinutes() );
-
-            nextSearchPoint.latitude_deg += totalLatitudeMinutes / 60;
-            nextSearchPoint.latitude_min = ( totalLatitudeMinutes - ( ( (int) totalLatitudeMinutes ) / 60 ) * 60 );
-            nextSearchPoint.longitude_deg += totalLongitudeMinutes / 60;
-            nextSearchPoint.longitude_min = ( totalLongitudeMinutes - ( ( (int) totalLongitudeMinutes) / 60 ) * 60 );
+            LocalPoint nextSearchPoint = { start.east + mSearchPointMultiplier.second * ( 2 * searchBailThresh ),
+                                           start.north + mSearchPointMultiplier.first * visionDistance };
 
             mSearchPointMultiplier.first -= 2;
             mSearchPoints.push_back( nextSearchPoint );
@@ -20,7 +20,7 @@ public:
     /*************************************************************************/
     /* Public Member Functions */
     /*************************************************************************/
-    SearchStateMachine( StateMachine* roverStateMachine, Rover* rover, const rapidjson::Document& roverConfig );
+    SearchStateMachine( StateMachine* roverStateMachine, Rover* rover, const NavConfig& roverConfig );
 
     virtual ~SearchStateMachine() {}
 
@@ -28,7 +28,7 @@ public:
 
     bool targetReachable( Rover* rover, double distance, double bearing );
 
-    virtual void initializeSearch( Rover* rover, const rapidjson::Document& roverConfig, double pathWidth ) = 0; // TODO
+    virtual void initializeSearch( Rover* rover, const NavConfig& roverConfig, double pathWidth ) = 0; // TODO
 
 protected:
     /*************************************************************************/
@@ -48,7 +48,7 @@ protected:
     vector< pair<short, short> > mSearchPointMultipliers;
 
     // Queue of search points.
-    deque<Odometry> mSearchPoints;
+    deque<LocalPoint> mSearchPoints;
 
     // Pointer to rover object
     Rover* mRover;
@@ -86,13 +86,13 @@ private:
     double mTurnToTargetRoverAngle;
 
     // Reference to config variables
-    const rapidjson::Document& mRoverConfig;
+    const NavConfig& mRoverConfig;
 
 };
 
 // Creates an ObstacleAvoidanceStateMachine object based on the inputted obstacle
 // avoidance algorithm. This allows for an an ease of transition between obstacle
 // avoidance algorithms
-SearchStateMachine* SearchFactory( StateMachine* stateMachine, SearchType type, Rover* rover, const rapidjson::Document& roverConfig );
+SearchStateMachine* SearchFactory( StateMachine* stateMachine, SearchType type, Rover* rover, const NavConfig& roverConfig );
 
 #endif //SEARCH_STATE_MACHINE_HPP
@@ -9,9 +9,10 @@ SpiralOut::~SpiralOut() {}
 
 // Initializes the search ponit multipliers to be the intermost loop
 // of the search.
-void SpiralOut::initializeSearch( Rover* rover, const rapidjson::Document& roverConfig, const double visionDistance )
+void SpiralOut::initializeSearch( Rover* rover, const NavConfig& roverConfig, const double visionDistance )
 {
     mSearchPoints.clear();
+    const LocalPoint center = rover->frame().toLocal( rover->roverStatus().path().front().odom );
 
     mSearchPointMultipliers.clear();
     mSearchPointMultipliers.push_back( pair<short, short> (  0,  1 ) );
@@ -19,19 +20,11 @@ void SpiralOut::initializeSearch( Rover* rover, const rapidjson::Document& rover
     mSearchPointMultipliers.push_back( pair<short, short> ( -1, -1 ) );
     mSearchPointMultipliers.push_back( pair<short, short> (  1, -1 ) );
 
-    while( mSearchPointMultipliers[ 0 ].second * visionDistance < roverConfig[ "search" ][ "bailThresh" ].GetDouble() ) {
+    while( mSearchPointMultipliers[ 0 ].second * visionDistance < roverConfig.search.bailThresh ) {
         for( auto& mSearchPointMultiplier : mSearchPointMultipliers )
         {
-            Odometry nextSearchPoint = rover->roverStatus().path().front().odom;
-            double totalLatitudeMinutes = nextSearchPoint.latitude_min +
-                ( mSearchPointMultiplier.first * visionDistance  * LAT_METER_IN_MINUTES );
-            double totalLongitudeMinutes = nextSearchPoint.longitude_min +
-                ( mSearchPointMultiplier.second * visionDistance * rover->longMeterInMinutes() );
-            nextSearchPoint.latitude_deg += totalLatitudeMinutes / 60;
-            nextSearchPoint.latitude_min = ( totalLatitudeMinutes - ( ( (int) totalLatitudeMinutes ) / 60 ) * 60 );
-            nextSearchPoint.longitude_deg += totalLongitudeMinutes / 60;
-            nextSearchPoint.longitude_min = ( totalLongitudeMinutes - ( ( (int) totalLongitudeMinutes) / 60 ) * 60 );
-
+            LocalPoint nextSearchPoint = { center.east + mSearchPointMultiplier.second * visionDistance,
+                                           center.north + mSearchPointMultiplier.first * visionDistance };
             mSearchPoints.push_back( nextSearchPoint );
 
             mSearchPointMultiplier.first < 0 ? --mSearchPointMultiplier.first : ++mSearchPointMultiplier.first;
@@ -6,14 +6,14 @@
 class SpiralOut : public SearchStateMachine
 {
 public:
-    SpiralOut( StateMachine* stateMachine_, Rover* rover, const rapidjson::Document& roverConfig )
+    SpiralOut( StateMachine* stateMachine_, Rover* rover, const NavConfig& roverConfig )
     : SearchStateMachine(stateMachine_, rover, roverConfig) {}
 
     ~SpiralOut();
 
     // Initializes the search ponit multipliers to be the intermost loop
     // of the search.
-    void initializeSearch( Rover* rover, const rapidjson::Document& roverConfig, const double pathWidth );
+    void initializeSearch( Rover* rover, const NavConfig& roverConfig, const double pathWidth );
 };
 
 #endif //SPIRAL_OUT_SEARCH_HPP
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <cassert>
 #include <cmath>
 #include <cstdlib>
 #include <map>
@@ -16,30 +17,20 @@
 #include "obstacle_avoidance/simpleAvoidance.hpp"
 #include "gate_search/diamondGateSearch.hpp"
 
-// Constructs a StateMachine object with the input lcm object.
-// Reads the configuartion file and constructs a Rover objet with this
-// and the lcmObject. Sets mStateChanged to true so that on the first
-// iteration of run the rover is updated.
-StateMachine::StateMachine( lcm::LCM& lcmObject )
+// Constructs a StateMachine object with the input lcm object and
+// configuration. Constructs a Rover objet with these. Sets
+// mStateChanged to true so that on the first iteration of run the
+// rover is updated.
+StateMachine::StateMachine( lcm::LCM& lcmObject, ConfigWatcher& configWatcher )
     : mRover( nullptr )
     , mLcmObject( lcmObject )
+    , mConfigWatcher( configWatcher )
+    , mRoverConfig( configWatcher.current() )
     , mTotalWaypoints( 0 )
     , mCompletedWaypoints( 0 )
     , mRepeaterDropComplete ( false )
     , mStateChanged( true )
 {
-    ifstream configFile;
-    string configPath = getenv("MROVER_CONFIG");
-    configPath += "/config_nav/config.json";
-    configFile.open( configPath );
-    string config = "";
-    string setting;
-    while( configFile >> setting )
-    {
-        config += setting;
-    }
-    configFile.close();
-    mRoverConfig.Parse( config.c_str() );
     mRover = new Rover( mRoverConfig, lcmObject );
     mSearchStateMachine = SearchFactory( this, SearchType::SPIRALOUT, mRover, mRoverConfig );
     mGateStateMachine = GateFactory( this, mRover, mRoverConfig );
@@ -53,7 +44,7 @@ StateMachine::~StateMachine( )
     delete mRover;
 }
 
-void StateMachine::setSearcher( SearchType type, Rover* rover, const rapidjson::Document& roverConfig )
+void StateMachine::setSearcher( SearchType type, Rover* rover, const NavConfig& roverConfig )
 {
     assert( mSearchStateMachine );
     delete mSearchStateMachine;
@@ -97,8 +88,13 @@ void StateMachine::updateObstacleElements( double bearing, double distance )
 // Runs the state machine through one iteration. The state machine will
 // run if the state has changed or if the rover's status has changed.
 // Will call the corresponding function based on the current state.
+// Picks up a saved configuration file before anything else.
 void StateMachine::run()
 {
+    if( mConfigWatcher.update() )
+    {
+        mRover->reloadConfig();
+    }
     publishNavState();
     if( isRoverReady() )
     {
@@ -176,9 +172,9 @@ void StateMachine::run()
             case NavState::ChangeSearchAlg:
             {
                 static int searchFails = 0;
-                static double visionDistance = mRoverConfig[ "computerVision" ][ "visionDistance" ].GetDouble();
+                static double visionDistance = mRoverConfig.computerVision.visionDistance;
 
-                switch( mRoverConfig[ "search" ][ "order" ][ searchFails % mRoverConfig[ "search" ][ "numSearches" ].GetInt() ].GetInt() )
+                switch( mRoverConfig.search.order[ searchFails % mRoverConfig.search.numSearches ] )
                 {
                     case 0:
                     {
@@ -243,46 +239,51 @@ void StateMachine::run()
     } // if
 } // run()
 
+// Returns the rate in Hz that run should be called at. The loop only
+// reads this at startup, so a new rate takes a restart.
+double StateMachine::loopRate() const
+{
+    return mRoverConfig.navLoop.rateHz;
+} // loopRate()
+
 // Updates the auton state (on/off) of the rover's status.
-void StateMachine::updateRoverStatus( AutonState autonState )
+void StateMachine::updateRoverStatus( const AutonState& autonState )
 {
-    mNewRoverStatus.autonState() = autonState;
+    mIncomingStatus.autonState.set( autonState );
 } // updateRoverStatus( AutonState )
 
 // Updates the course of the rover's status if it has changed.
-void StateMachine::updateRoverStatus( Course course )
+void StateMachine::updateRoverStatus( const Course& course )
 {
-    if( mNewRoverStatus.course().hash != course.hash )
+    if( mIncomingStatus.course.value().hash != course.hash )
     {
-        mNewRoverStatus.course() = course;
+        mIncomingStatus.course.set( course );
     }
 } // updateRoverStatus( Course )
 
 // Updates the obstacle information of the rover's status.
-void StateMachine::updateRoverStatus( Obstacle obstacle )
+void StateMachine::updateRoverStatus( const Obstacle& obstacle )
 {
-    mNewRoverStatus.obstacle() = obstacle;
+    mIncomingStatus.obstacle.set( obstacle );
 } // updateRoverStatus( Obstacle )
 
 // Updates the odometry information of the rover's status.
-void StateMachine::updateRoverStatus( Odometry odometry )
+void StateMachine::updateRoverStatus( const Odometry& odometry )
 {
-    mNewRoverStatus.odometry() = odometry;
+    mIncomingStatus.odometry.set( odometry );
 } // updateRoverStatus( Odometry )
 
 // Updates the target information of the rover's status.
-void StateMachine::updateRoverStatus( TargetList targetList )
+void StateMachine::updateRoverStatus( const TargetList& targetList )
 {
-    Target target1 = targetList.targetList[0];
-    Target target2 = targetList.targetList[1];
-    mNewRoverStatus.target() = target1;
-    mNewRoverStatus.target2() = target2;
+    mIncomingStatus.target.set( targetList.targetList[0] );
+    mIncomingStatus.target2.set( targetList.targetList[1] );
 } // updateRoverStatus( Target )
 
 // Updates the radio signal strength information of the rover's status.
-void StateMachine::updateRoverStatus( RadioSignalStrength radioSignalStrength )
+void StateMachine::updateRoverStatus( const RadioSignalStrength& radioSignalStrength )
 {
-    mNewRoverStatus.radio() = radioSignalStrength;
+    mIncomingStatus.radio.set( radioSignalStrength );
 } // updateRoverStatus( RadioSignalStrength )
 
 // Return true if we want to execute a loop in the state machine, false
@@ -290,7 +291,7 @@ void StateMachine::updateRoverStatus( RadioSignalStrength radioSignalStrength )
 bool StateMachine::isRoverReady() const
 {
     return mStateChanged || // internal data has changed
-           mRover->updateRover( mNewRoverStatus ) || // external data has changed
+           mRover->updateRover( mIncomingStatus ) || // external data has changed
            mRover->roverStatus().currentState() == NavState::SearchSpinWait || // continue even if no data has changed
            mRover->roverStatus().currentState() == NavState::TurnedToTargetWait || // continue even if no data has changed
            mRover->roverStatus().currentState() == NavState::RepeaterDropWait ||
@@ -305,7 +306,7 @@ void StateMachine::publishNavState() const
     navStatus.nav_state_name = stringifyNavState();
     navStatus.completed_wps = mCompletedWaypoints;
     navStatus.total_wps = mTotalWaypoints;
-    const string& navStatusChannel = mRoverConfig[ "lcmChannels" ][ "navStatusChannel" ].GetString();
+    const string& navStatusChannel = mRoverConfig.lcmChannels.navStatusChannel;
     mLcmObject.publish( navStatusChannel, &navStatus );
 } // publishNavState()
 
@@ -381,7 +382,7 @@ NavState StateMachine::executeTurn()
 NavState StateMachine::executeDrive()
 {
     const Waypoint& nextWaypoint = mRover->roverStatus().path().front();
-    double distance = estimateNoneuclid( mRover->roverStatus().odometry(), nextWaypoint.odom );
+    double distance = calcDistance( mRover->position(), mRover->frame().toLocal( nextWaypoint.odom ) );
 
     // If we should drop a repeater and have not already, add last
     // point where connection was good to front of path and turn
@@ -437,7 +438,7 @@ NavState StateMachine::executeRepeaterDropWait( )
 {
 
     RepeaterDrop rr_init;
-    const string& radioRepeaterInitChannel = mRoverConfig[ "lcmChannels" ][ "repeaterDropInitChannel" ].GetString();
+    const string& radioRepeaterInitChannel = mRoverConfig.lcmChannels.repeaterDropInitChannel;
     mLcmObject.publish( radioRepeaterInitChannel, &rr_init );
 
     if( mRepeaterDropComplete )
@@ -496,12 +497,12 @@ double StateMachine::getOptimalAvoidanceAngle() const
 // Returns the optimal angle to avoid the detected obstacle.
 double StateMachine::getOptimalAvoidanceDistance() const
 {
-    return mRover->roverStatus().obstacle().distance + mRoverConfig[ "navThresholds" ][ "waypointDistance" ].GetDouble();
+    return mRover->roverStatus().obstacle().distance + mRoverConfig.navThresholds.waypointDistance;
 } // optimalAvoidanceAngle()
 
 bool StateMachine::isWaypointReachable( double distance )
 {
-    return isLocationReachable( mRover, mRoverConfig, distance, mRoverConfig["navThresholds"]["waypointDistance"].GetDouble());
+    return isLocationReachable( mRover, mRoverConfig, distance, mRoverConfig.navThresholds.waypointDistance);
 } // isWaypointReachable
 
 // If we have not already begun to drop radio repeater
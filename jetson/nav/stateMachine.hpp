@@ -2,7 +2,7 @@
 #define STATE_MACHINE_HPP
 
 #include <lcm/lcm-cpp.hpp>
-#include "rapidjson/document.h"
+#include "navConfig.hpp"
 #include "rover.hpp"
 #include "search/searchStateMachine.hpp"
 #include "gate_search/gateStateMachine.hpp"
@@ -19,25 +19,27 @@ public:
     /*************************************************************************/
     /* Public Member Functions */
     /*************************************************************************/
-    StateMachine( lcm::LCM& lcmObject );
+    StateMachine( lcm::LCM& lcmObject, ConfigWatcher& configWatcher );
 
     ~StateMachine();
 
     void run( );
 
-    void updateRoverStatus( AutonState autonState );
+    double loopRate() const;
 
-    void updateRoverStatus( Bearing bearing );
+    void updateRoverStatus( const AutonState& autonState );
 
-    void updateRoverStatus( Course course );
+    void updateRoverStatus( const Bearing& bearing );
 
-    void updateRoverStatus( Obstacle obstacle );
+    void updateRoverStatus( const Course& course );
 
-    void updateRoverStatus( Odometry odometry );
+    void updateRoverStatus( const Obstacle& obstacle );
 
-    void updateRoverStatus( TargetList targetList );
+    void updateRoverStatus( const Odometry& odometry );
 
-    void updateRoverStatus( RadioSignalStrength radioSignalStrength );
+    void updateRoverStatus( const TargetList& targetList );
+
+    void updateRoverStatus( const RadioSignalStrength& radioSignalStrength );
 
     void updateCompletedPoints( );
 
@@ -49,7 +51,7 @@ public:
 
     void updateRepeaterComplete( );
 
-    void setSearcher(SearchType type, Rover* rover, const rapidjson::Document& roverConfig );
+    void setSearcher(SearchType type, Rover* rover, const NavConfig& roverConfig );
 
     /*************************************************************************/
     /* Public Member Variables */
@@ -99,14 +101,18 @@ private:
     // Rover object to do basic rover operations in the state machine.
     Rover* mRover;
 
-    // RoverStatus object for updating the rover's status.
-    Rover::RoverStatus mNewRoverStatus;
+    // Newest status from lcm, applied to the rover's status on each
+    // iteration of run.
+    Rover::IncomingStatus mIncomingStatus;
 
     // Lcm object for sending and recieving messages.
     lcm::LCM& mLcmObject;
 
-    // Configuration file for the rover.
-    rapidjson::Document mRoverConfig;
+    // Reloads the configuration between iterations of run.
+    ConfigWatcher& mConfigWatcher;
+
+    // Configuration for the rover, owned by mConfigWatcher.
+    const NavConfig& mRoverConfig;
 
     // Number of waypoints in course.
     unsigned mTotalWaypoints;
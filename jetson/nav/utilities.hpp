@@ -9,22 +9,17 @@
 using namespace std;
 using namespace rover_msgs;
 
-const int EARTH_RADIUS = 6371000; // meters
-const int EARTH_CIRCUM = 40075000; // meters
 const double PI = 3.141592654; // radians
-const double LAT_METER_IN_MINUTES = 0.0005389625; // minutes/meters
 
 double degreeToRadian( const double degree, const double minute = 0 );
 
 double radianToDegree( const double radian );
 
-Odometry addMinToDegrees( const Odometry & current, const double lat_minutes = 0, const double lon_minutes = 0 );
+double calcDistance( const LocalPoint& start, const LocalPoint& dest );
 
-double estimateNoneuclid( const Odometry& start, const Odometry& dest );
+LocalPoint createPoint( const LocalPoint& current, const double bearing, const double distance );
 
-Odometry createOdom ( const Odometry & current, const double bearing, const double distance, Rover * rover );
-
-double calcBearing( const Odometry& start, const Odometry& dest );
+double calcBearing( const LocalPoint& start, const LocalPoint& dest );
 
 double mod( const double degree, const int modulus );
 
@@ -32,12 +27,12 @@ void throughZero( double& destinationBearing, const double currentBearing );
 
 void clear( deque<Waypoint>& aDeque );
 
-bool isTargetReachable( Rover* rover, const rapidjson::Document& roverConfig );
+bool isTargetReachable( Rover* rover, const NavConfig& roverConfig );
 
-bool isLocationReachable( Rover* rover, const rapidjson::Document& roverConfig, const double locDist, const double distThresh );
+bool isLocationReachable( Rover* rover, const NavConfig& roverConfig, const double locDist, const double distThresh );
 
 bool isObstacleDetected( Rover* rover );
 
-bool isObstacleInThreshold( Rover* rover, const rapidjson::Document& roverConfig );
+bool isObstacleInThreshold( Rover* rover, const NavConfig& roverConfig );
 
 #endif // NAV_UTILITES
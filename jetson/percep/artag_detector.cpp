@@ -24,7 +24,22 @@ TagDetector::TagDetector(const rapidjson::Document &mRoverConfig) :
    DO_CORNER_REFINEMENT{!!mRoverConfig["alvar_params"]["do_corner_refinement"].GetInt()},
    POLYGONAL_APPROX_ACCURACY_RATE{mRoverConfig["alvar_params"]["polygonal_approx_accuracy_rate"].GetDouble()},
    MM_PER_M{mRoverConfig["mm_per_m"].GetInt()},
-   DEFAULT_TAG_VAL{mRoverConfig["ar_tag"]["default_tag_val"].GetInt()} {
+   DEFAULT_TAG_VAL{mRoverConfig["ar_tag"]["default_tag_val"].GetInt()},
+   ROI_TRACKING{!!mRoverConfig["ar_tag"]["roi_tracking"].GetInt()},
+   ROI_PADDING{mRoverConfig["ar_tag"]["roi_padding"].GetDouble()},
+   FULL_SEARCH_INTERVAL{mRoverConfig["ar_tag"]["full_search_interval"].GetInt()},
+   FULL_SEARCH_SCALE{mRoverConfig["ar_tag"]["full_search_scale"].GetDouble()},
+   PYRAMID_SEARCH{!!mRoverConfig["ar_tag"]["pyramid"]["enabled"].GetInt()},
+   PYRAMID_MAX_CANDIDATES{mRoverConfig["ar_tag"]["pyramid"]["max_candidates"].GetInt()},
+   PYRAMID_MIN_PERIMETER_RATE{mRoverConfig["ar_tag"]["pyramid"]["min_perimeter_rate"].GetDouble()},
+   DEPTH_MAX_SAMPLES{mRoverConfig["ar_tag"]["depth"]["max_samples"].GetInt()},
+   DEPTH_MIN_SAMPLES{mRoverConfig["ar_tag"]["depth"]["min_samples"].GetInt()},
+   DEPTH_TRIM_FRACTION{mRoverConfig["ar_tag"]["depth"]["trim_fraction"].GetDouble()},
+   DEPTH_AGREEMENT{mRoverConfig["ar_tag"]["depth"]["agreement"].GetDouble()},
+   DEPTH_MIN_CONFIDENCE{mRoverConfig["ar_tag"]["depth"]["min_confidence"].GetDouble()},
+   VELOCITY_SMOOTHING{mRoverConfig["ar_tag"]["tracker"]["velocity_smoothing"].GetDouble()},
+   MAX_PREDICTION_S{mRoverConfig["ar_tag"]["tracker"]["max_prediction_s"].GetDouble()},
+   framesSinceFullSearch{0}, frameWidth{0}, frameNs{0} {
 
     cv::FileStorage fsr("jetson/percep/alvar_dict.yml", cv::FileStorage::READ);
     if (!fsr.isOpened()) {  //throw error if dictionary file does not exist
@@ -46,6 +61,17 @@ TagDetector::TagDetector(const rapidjson::Document &mRoverConfig) :
     alvarParams->markerBorderBits = MARKER_BORDER_BITS;
     alvarParams->doCornerRefinement = DO_CORNER_REFINEMENT;
     alvarParams->polygonalApproxAccuracyRate = POLYGONAL_APPROX_ACCURACY_RATE;
+
+    // candidates only need to be found, corners are refined when the full resolution crop is decoded
+    candidateParams = new cv::aruco::DetectorParameters(*alvarParams);
+    candidateParams->minMarkerPerimeterRate = PYRAMID_MIN_PERIMETER_RATE;
+    candidateParams->doCornerRefinement = false;
+
+    // every slot starts free
+    trackSlot.assign(bits.rows, -1);
+    for (auto &track : tracks) {
+        track.id = DEFAULT_TAG_VAL;
+    }
 }
 
 Point2f TagDetector::getAverageTagCoordinateFromCorners(const vector<Point2f> &corners) {  //gets coordinate of center of tag
@@ -62,18 +88,11 @@ Point2f TagDetector::getAverageTagCoordinateFromCorners(const vector<Point2f> &c
     return avgCoord;
 }
 
-pair<Tag, Tag> TagDetector::findARTags(Mat &src, Mat &depth_src, Mat &rgb) {  //detects AR tags in source Mat and outputs Tag objects for use in LCM
-    // RETURN:
-    // pair of target objects- each object has an x and y for the center,
-    // and the tag ID number return them such that the "leftmost" (x
-    // coordinate) tag is at index 0
+void TagDetector::findARTags(Mat &src, Mat &depth_src, Mat &rgb, int64_t captureNs) {  //detects AR tags in source Mat and feeds them to the tracks
     cvtColor(src, rgb, COLOR_RGBA2RGB);
-    // clear ids and corners vectors for each detection
-    ids.clear();
-    corners.clear();
 
     // Find tags
-    cv::aruco::detectMarkers(rgb, alvarDict, corners, ids, alvarParams);
+    detectTags(rgb);
     #if AR_RECORD
     cv::aruco::drawDetectedMarkers(rgb, corners, ids);
     #endif
@@ -89,50 +108,193 @@ pair<Tag, Tag> TagDetector::findARTags(Mat &src, Mat &depth_src, Mat &rgb) {  //
     setMouseCallback("Obstacle", onMouse);
     #endif
 
-    // create Tag objects for the detected tags and return them
-    pair<Tag, Tag> discoveredTags;
-    if (ids.size() == 0) {
-        // no tags found, return invalid objects with tag set to -1
-        discoveredTags.first.id = DEFAULT_TAG_VAL;
-        discoveredTags.first.loc = Point2f();
-        discoveredTags.second.id = DEFAULT_TAG_VAL;
-        discoveredTags.second.loc = Point2f();
-
-    } else if (ids.size() == 1) {  // exactly one tag found
-        discoveredTags.first.id = ids[0];
-        discoveredTags.first.loc = getAverageTagCoordinateFromCorners(corners[0]);
-        // set second tag to invalid object with tag as -1
-        discoveredTags.second.id = DEFAULT_TAG_VAL;
-        discoveredTags.second.loc = Point2f();
-    } else if (ids.size() == 2) {  // exactly two tags found
-        Tag t0, t1;
-        t0.id = ids[0];
-        t0.loc = getAverageTagCoordinateFromCorners(corners[0]);
-        t1.id = ids[1];
-        t1.loc = getAverageTagCoordinateFromCorners(corners[1]);
-        if (t0.loc.x < t1.loc.x) {  //if tag 0 is left of tag 1, put t0 first
-            discoveredTags.first = t0;
-            discoveredTags.second = t1;
-        } else {  //tag 1 is left of tag 0, put t1 first
-            discoveredTags.first = t1;
-            discoveredTags.second = t0;
+    frameWidth = src.cols;
+    frameNs = captureNs;
+    updateTracks(depth_src);
+}
+
+void TagDetector::detectTags(const Mat &rgb) {
+    // Tags move only a little between frames, so while we are tracking them
+    // a small box around last frame's corners is searched instead of the whole
+    // image. The whole frame is still searched every FULL_SEARCH_INTERVAL
+    // frames to pick up tags that came into view, and whenever tracking loses them
+    bool tracking = ROI_TRACKING && !lastCorners.empty() && framesSinceFullSearch < FULL_SEARCH_INTERVAL;
+    if (tracking) {
+        ids.clear();
+        corners.clear();
+        detectInRegion(rgb, paddedRegion(lastCorners, rgb.size()));
+        ++framesSinceFullSearch;
+    }
+    if (!tracking || ids.empty()) {
+        detectFullFrame(rgb);
+        framesSinceFullSearch = 0;
+    }
+    lastCorners = corners;
+}
+
+void TagDetector::detectFullFrame(const Mat &rgb) {
+    ids.clear();
+    corners.clear();
+    if (FULL_SEARCH_SCALE >= 1.0) {
+        cv::aruco::detectMarkers(rgb, alvarDict, corners, ids, alvarParams);
+        return;
+    }
+    if (PYRAMID_SEARCH) {
+        detectPyramid(rgb);
+        return;
+    }
+
+    resize(rgb, scaled, Size(), FULL_SEARCH_SCALE, FULL_SEARCH_SCALE, INTER_AREA);
+    cv::aruco::detectMarkers(scaled, alvarDict, corners, ids, alvarParams);
+    scaleCornersToFull(corners, FULL_SEARCH_SCALE);
+}
+
+void TagDetector::detectPyramid(const Mat &rgb) {
+    // Far away tags are only a few pixels wide, too few to decode once downscaled,
+    // but their outline still shows up as a quad. Every quad found on the small
+    // image, decoded or rejected, is decoded again on a full resolution crop.
+    // aruco's minimum perimeter is relative to the image it is given, so on a
+    // crop a tiny tag is large enough to be accepted
+    resize(rgb, scaled, Size(), FULL_SEARCH_SCALE, FULL_SEARCH_SCALE, INTER_AREA);
+    vector<int> candidateIds;
+    vector<vector<Point2f> > candidates, rejected;
+    cv::aruco::detectMarkers(scaled, alvarDict, candidates, candidateIds, candidateParams, rejected);
+
+    // decoded quads go first so they survive the candidate limit
+    candidates.insert(candidates.end(), rejected.begin(), rejected.end());
+    if ((int)candidates.size() > PYRAMID_MAX_CANDIDATES) {
+        candidates.resize(PYRAMID_MAX_CANDIDATES);
+    }
+    scaleCornersToFull(candidates, FULL_SEARCH_SCALE);
+
+    vector<Rect> searched;
+    for (auto &candidate : candidates) {
+        // a candidate inside a crop we already decoded would only find the same tag again
+        Point2f center = getAverageTagCoordinateFromCorners(candidate);
+        bool covered = false;
+        for (auto &region : searched) {
+            covered = covered || region.contains(center);
+        }
+        if (covered) continue;
+
+        Rect region = paddedRegion(vector<vector<Point2f> >(1, candidate), rgb.size());
+        searched.push_back(region);
+        detectInRegion(rgb, region);
+    }
+}
+
+void TagDetector::detectInRegion(const Mat &rgb, const Rect &region) {
+    if (region.area() == 0) return;
+
+    // rgb(region) shares memory with rgb, nothing is copied
+    vector<int> regionIds;
+    vector<vector<Point2f> > regionCorners;
+    cv::aruco::detectMarkers(rgb(region), alvarDict, regionCorners, regionIds, alvarParams);
+
+    Point2f offset(region.x, region.y);
+    for (auto &tagCorners : regionCorners) {
+        for (auto &corner : tagCorners) {
+            corner += offset;
+        }
+    }
+    ids.insert(ids.end(), regionIds.begin(), regionIds.end());
+    corners.insert(corners.end(), regionCorners.begin(), regionCorners.end());
+}
+
+void TagDetector::scaleCornersToFull(vector<vector<Point2f> > &tagCorners, double scale) {
+    // pixel centers line up at (p + 0.5) / scale
+    for (auto &tag : tagCorners) {
+        for (auto &corner : tag) {
+            corner.x = (corner.x + 0.5f) / scale - 0.5f;
+            corner.y = (corner.y + 0.5f) / scale - 0.5f;
+        }
+    }
+}
+
+Rect TagDetector::paddedRegion(const vector<vector<Point2f> > &tagCorners, const Size &frameSize) {
+    // bounding box of every tag, padded by the size of the largest one
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float tagSize = 0;
+    for (auto &tag : tagCorners) {
+        Rect2f bounds = boundingRect(tag);
+        minX = std::min(minX, bounds.x);
+        minY = std::min(minY, bounds.y);
+        maxX = std::max(maxX, bounds.x + bounds.width);
+        maxY = std::max(maxY, bounds.y + bounds.height);
+        tagSize = std::max(tagSize, std::max(bounds.width, bounds.height));
+    }
+    float pad = ROI_PADDING * tagSize;
+
+    Rect region(Point((int)std::floor(minX - pad), (int)std::floor(minY - pad)),
+                Point((int)std::ceil(maxX + pad), (int)std::ceil(maxY + pad)));
+    return region & Rect(Point(0, 0), frameSize);
+}
+
+float TagDetector::estimateTagDepth(const Mat &depth_img, const vector<Point2f> &tagCorners, float &confidence) {
+    // A single pixel at the tag's center is often NaN or falls through a hole in
+    // the depth map, so every pixel inside the tag is a candidate instead
+    confidence = 0;
+    vector<Point> quad;
+    for (auto &corner : tagCorners) {
+        quad.push_back(Point(cvRound(corner.x), cvRound(corner.y)));
+    }
+    Rect box = boundingRect(quad) & Rect(Point(0, 0), depth_img.size());
+    if (box.area() == 0) return NAN;
+
+    // rasterize the quad into a mask over its bounding box
+    footprintMask.create(box.size(), CV_8UC1);
+    footprintMask.setTo(Scalar(0));
+    for (auto &point : quad) {
+        point -= box.tl();
+    }
+    fillConvexPoly(footprintMask, quad, Scalar(255));
+
+    // close tags cover tens of thousands of pixels, sample on a grid so the cost stays bounded
+    int footprint = countNonZero(footprintMask);
+    int step = std::max(1, (int)std::ceil(std::sqrt((double)footprint / DEPTH_MAX_SAMPLES)));
+
+    depthSamples.clear();
+    int sampled = 0;
+    for (int r = 0; r < box.height; r += step) {
+        const float *depthRow = depth_img.ptr<float>(box.y + r) + box.x;
+        const uchar *maskRow = footprintMask.ptr<uchar>(r);
+        for (int c = 0; c < box.width; c += step) {
+            if (!maskRow[c]) continue;
+            ++sampled;
+            // the ZED marks pixels it could not match as NaN or +-inf
+            if (std::isfinite(depthRow[c]) && depthRow[c] > 0) {
+                depthSamples.push_back(depthRow[c]);
+            }
         }
-    } else {  // detected >=3 tags
-        // return leftmost and rightsmost detected tags to account for potentially seeing 2 of each tag on a post
-        Tag t0, t1;
-        t0.id = ids[0];
-        t0.loc = getAverageTagCoordinateFromCorners(corners[0]);
-        t1.id = ids[ids.size() - 1];
-        t1.loc = getAverageTagCoordinateFromCorners(corners[ids.size() - 1]);
-        if (t0.loc.x < t1.loc.x) {  //if tag 0 is left of tag 1, put t0 first
-            discoveredTags.first = t0;
-            discoveredTags.second = t1;
-        } else {  //tag 1 is left of tag 0, put t1 first
-            discoveredTags.first = t1;
-            discoveredTags.second = t0;
+    }
+    if (depthSamples.empty() || (int)depthSamples.size() < DEPTH_MIN_SAMPLES) return NAN;
+
+    float estimate;
+    size_t n = depthSamples.size();
+    if (DEPTH_TRIM_FRACTION > 0) {
+        // mean of the samples left after dropping TRIM_FRACTION from each end
+        size_t lo = (size_t)(n * DEPTH_TRIM_FRACTION);
+        size_t hi = std::max(lo + 1, n - lo);
+        std::nth_element(depthSamples.begin(), depthSamples.begin() + lo, depthSamples.end());
+        if (hi < n) {
+            std::nth_element(depthSamples.begin() + lo, depthSamples.begin() + hi, depthSamples.end());
         }
+        double sum = 0;
+        for (size_t i = lo; i < hi; ++i) sum += depthSamples[i];
+        estimate = sum / (hi - lo);
+    } else {
+        std::nth_element(depthSamples.begin(), depthSamples.begin() + n / 2, depthSamples.end());
+        estimate = depthSamples[n / 2];
+    }
+
+    // pixels that were invalid count against the confidence as well as ones that disagree
+    int agreeing = 0;
+    float tolerance = DEPTH_AGREEMENT * estimate;
+    for (float sample : depthSamples) {
+        agreeing += std::abs(sample - estimate) <= tolerance;
     }
-    return discoveredTags;
+    confidence = (float)agreeing / sampled;
+    return estimate;
 }
 
 double TagDetector::getAngle(float xPixel, float wPixel){
@@ -140,41 +302,131 @@ double TagDetector::getAngle(float xPixel, float wPixel){
     return atan((xPixel - wPixel/2)/(wPixel/2)* tan(fieldofView/2))* 180.0 /PI;
 }
 
-void TagDetector::updateDetectedTagInfo(rover_msgs::Target *arTags, pair<Tag, Tag> &tagPair, Mat &depth_img, Mat &src){
-    struct tagPairs {
-        vector<int> id;
-        vector<int> locx;
-        vector<int> locy;
-        vector<int> buffer;
-    }; 
-    tagPairs tags;
-
-    tags.id.push_back(tagPair.first.id);
-    tags.locx.push_back(tagPair.first.loc.x);
-    tags.locy.push_back(tagPair.first.loc.y);
-    tags.id.push_back(tagPair.second.id);
-    tags.locx.push_back(tagPair.second.loc.x);
-    tags.locy.push_back(tagPair.second.loc.y);
-    tags.buffer.push_back(0);
-    tags.buffer.push_back(0);
-
-  for (uint i=0; i<2; i++) {
-    if(tags.id[i] == DEFAULT_TAG_VAL){ //no tag found
-        if(tags.buffer[i] <= BUFFER_ITERATIONS){ //send buffered tag until tag is found
-            ++tags.buffer[i];
-        } else { //if still no tag found, set all stats to -1
+int TagDetector::acquireTrack(int id, const bool *seen) {
+    if (trackSlot[id] >= 0) return trackSlot[id];
+
+    // reuse a free slot, or give up the one that has gone longest without a detection
+    // a tag seen this frame keeps its slot and the new ID waits for a later frame
+    int slot = -1;
+    for (int i = 0; i < MAX_TRACKED_TAGS; ++i) {
+        if (tracks[i].id == DEFAULT_TAG_VAL) {
+            slot = i;
+            break;
+        }
+        if (!seen[i] && (slot < 0 || tracks[i].missedFrames > tracks[slot].missedFrames)) {
+            slot = i;
+        }
+    }
+    if (slot < 0) return -1;
+    if (tracks[slot].id != DEFAULT_TAG_VAL) {
+        trackSlot[tracks[slot].id] = -1;
+    }
+
+    TrackedTag &track = tracks[slot];
+    track.id = id;
+    track.distance = DEFAULT_TAG_VAL;
+    track.bearingRate = 0;
+    track.distanceRate = 0;
+    track.missedFrames = 0;
+    trackSlot[id] = slot;
+    return slot;
+}
+
+void TagDetector::updateTracks(const Mat &depth_src) {
+    bool seen[MAX_TRACKED_TAGS] = {};
+
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] < 0 || ids[i] >= (int)trackSlot.size()) continue;
+
+        // a post shows the same ID on several faces, the first one found this frame wins
+        bool known = trackSlot[ids[i]] >= 0;
+        int slot = acquireTrack(ids[i], seen);
+        if (slot < 0 || seen[slot]) continue;
+        seen[slot] = true;
+
+        TrackedTag &track = tracks[slot];
+        Point2f loc = getAverageTagCoordinateFromCorners(corners[i]);
+        double bearing = getAngle(loc.x, frameWidth);
+        float confidence;
+        float depth = estimateTagDepth(depth_src, corners[i], confidence);
+        bool depthValid = !isnan(depth) && confidence >= DEPTH_MIN_CONFIDENCE;
+        double distance = depthValid ? depth / MM_PER_M : track.distance;
+
+        // rates are smoothed finite differences against the last detection
+        double dt = (frameNs - track.lastSeenNs) / 1e9;
+        if (known && dt > 0 && dt <= MAX_PREDICTION_S) {
+            track.bearingRate += VELOCITY_SMOOTHING * ((bearing - track.bearing) / dt - track.bearingRate);
+            if (depthValid && track.distance >= 0) {
+                track.distanceRate += VELOCITY_SMOOTHING * ((distance - track.distance) / dt - track.distanceRate);
+            }
+        } else {
+            track.bearingRate = 0;
+            track.distanceRate = 0;
+        }
+
+        track.loc = loc;
+        track.bearing = bearing;
+        track.distance = distance;
+        track.lastSeenNs = frameNs;
+        track.missedFrames = 0;
+    }
+
+    // tags that were not seen are held for BUFFER_ITERATIONS frames, then dropped
+    for (int slot = 0; slot < MAX_TRACKED_TAGS; ++slot) {
+        TrackedTag &track = tracks[slot];
+        if (track.id == DEFAULT_TAG_VAL || seen[slot]) continue;
+        if (++track.missedFrames > BUFFER_ITERATIONS) {
+            trackSlot[track.id] = -1;
+            track.id = DEFAULT_TAG_VAL;
+        }
+    }
+}
+
+void TagDetector::updateDetectedTagInfo(rover_msgs::Target *arTags) {
+    // report the two most recently seen tags, nearest first on ties
+    const TrackedTag *best[2] = {nullptr, nullptr};
+    auto better = [](const TrackedTag *a, const TrackedTag *b) {
+        if (!b) return true;
+        if (a->missedFrames != b->missedFrames) return a->missedFrames < b->missedFrames;
+        return a->distance >= 0 && (b->distance < 0 || a->distance < b->distance);
+    };
+    for (const TrackedTag &track : tracks) {
+        if (track.id == DEFAULT_TAG_VAL) continue;
+        if (better(&track, best[0])) {
+            best[1] = best[0];
+            best[0] = &track;
+        } else if (better(&track, best[1])) {
+            best[1] = &track;
+        }
+    }
+    // the leftmost tag goes first
+    if (best[1] && best[1]->bearing < best[0]->bearing) {
+        std::swap(best[0], best[1]);
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (!best[i]) {
             arTags[i].distance = DEFAULT_TAG_VAL;
             arTags[i].bearing = DEFAULT_TAG_VAL;
             arTags[i].id = DEFAULT_TAG_VAL;
+            continue;
         }
-     } else { //tag found
-    if(!isnan(depth_img.at<float>(tags.locy.at(i), tags.locx.at(i)))) {
-        arTags[i].distance = depth_img.at<float>(tags.locy.at(i), tags.locx.at(i)) / MM_PER_M;
+
+        // held tags coast on their rates, but only for a short while
+        const TrackedTag &track = *best[i];
+        double elapsed = std::min((frameNs - track.lastSeenNs) / 1e9, MAX_PREDICTION_S);
+        arTags[i].bearing = track.bearing + track.bearingRate * elapsed;
+        arTags[i].distance = track.distance < 0 ? DEFAULT_TAG_VAL : std::max(0.0, track.distance + track.distanceRate * elapsed);
+        arTags[i].id = track.id;
     }
-        arTags[i].bearing = getAngle((int)tags.locx.at(i), src.cols);
-        arTags[i].id = tags.id.at(i);
-        tags.buffer[i] = 0;
-   }
-  }
 }
 
+void TagDetector::drawTags(Mat &image, double scale) const {  //outlines last frame's tags on a resized copy of it
+    vector<vector<Point2f> > scaledCorners(corners);
+    for (auto &tagCorners : scaledCorners) {
+        for (auto &corner : tagCorners) {
+            corner *= scale;
+        }
+    }
+    cv::aruco::drawDetectedMarkers(image, scaledCorners, ids);
+}
@@ -1,24 +1,76 @@
 #pragma once
 
 #include <vector>
+#include <cfloat>
+#include <cstdint>
 #include "perception.hpp"
 #include "rover_msgs/Target.hpp"
 
 using namespace std;
 using namespace cv;
 
-struct Tag {
+//Everything known about one tag ID across frames
+struct TrackedTag {
+    int id; //DEFAULT_TAG_VAL if the slot is free
     Point2f loc;
-    int id;
+    double bearing; //degrees from straight ahead
+    double distance; //meters, DEFAULT_TAG_VAL until a confident depth is seen
+    double bearingRate; //degrees per second
+    double distanceRate; //meters per second
+    int64_t lastSeenNs; //capture time of the last detection
+    int missedFrames; //frames since the tag was last detected
 };
 
+//Most tags that can be tracked at once, a gate shows at most two IDs
+const int MAX_TRACKED_TAGS = 8;
+
 class TagDetector {
    private:
     Ptr<cv::aruco::Dictionary> alvarDict;
     Ptr<cv::aruco::DetectorParameters> alvarParams;
+    //Looser parameters used to find candidate quads on the downscaled frame
+    Ptr<cv::aruco::DetectorParameters> candidateParams;
     std::vector<int> ids;
     std::vector<std::vector<cv::Point2f> > corners;
     cv::Mat rgb;
+
+    //Corners found last frame, seeds the region of interest for this frame
+    std::vector<std::vector<cv::Point2f> > lastCorners;
+    //Frames since the whole image was last searched
+    int framesSinceFullSearch;
+    //Downscaled copy of the frame reused by full searches
+    cv::Mat scaled;
+
+    //Scratch space reused by estimateTagDepth
+    cv::Mat footprintMask;
+    vector<float> depthSamples;
+
+    //Tracks live in a fixed array, trackSlot maps a tag ID to its index or -1
+    TrackedTag tracks[MAX_TRACKED_TAGS];
+    vector<int> trackSlot;
+    //Width of the last frame, needed to turn pixels into bearings
+    int frameWidth;
+    //Capture time of the last frame, the clock rates and coasting are measured on
+    int64_t frameNs;
+
+    //Updates the tracks with this frame's detections and ages the ones that were not seen
+    void updateTracks(const Mat &depth_src);
+    //Slot for id, taking over a free or the stalest slot if id is not tracked yet
+    //Slots already updated this frame are never taken, -1 if every slot was
+    int acquireTrack(int id, const bool *seen);
+
+    //Searches a padded box around last frame's tags, then the whole frame if they were lost
+    void detectTags(const Mat &rgb);
+    //Searches the whole frame at FULL_SEARCH_SCALE
+    void detectFullFrame(const Mat &rgb);
+    //Finds candidate quads at FULL_SEARCH_SCALE and decodes each one on a full resolution crop
+    void detectPyramid(const Mat &rgb);
+    //Searches only region of rgb and adds what it finds to ids and corners in full frame coordinates
+    void detectInRegion(const Mat &rgb, const Rect &region);
+    //Maps corners found on an image downscaled by scale back to full resolution
+    void scaleCornersToFull(vector<vector<Point2f> > &tagCorners, double scale);
+    //Bounding box of corners grown by ROI_PADDING tag sizes on each side and clipped to the frame
+    Rect paddedRegion(const vector<vector<Point2f> > &tagCorners, const Size &frameSize);
     
    public:
    //Constants:
@@ -28,16 +80,37 @@ class TagDetector {
    double POLYGONAL_APPROX_ACCURACY_RATE;
    int MM_PER_M;
    int DEFAULT_TAG_VAL;
+   bool ROI_TRACKING;
+   double ROI_PADDING;
+   int FULL_SEARCH_INTERVAL;
+   double FULL_SEARCH_SCALE;
+   bool PYRAMID_SEARCH;
+   int PYRAMID_MAX_CANDIDATES;
+   double PYRAMID_MIN_PERIMETER_RATE;
+   int DEPTH_MAX_SAMPLES;
+   int DEPTH_MIN_SAMPLES;
+   double DEPTH_TRIM_FRACTION; //in [0, 0.5), checked when the config is loaded
+   double DEPTH_AGREEMENT;
+   double DEPTH_MIN_CONFIDENCE;
+   double VELOCITY_SMOOTHING;
+   double MAX_PREDICTION_S;
 
     //constructor loads alvar dictionary data from file that defines tag bit configurations
     TagDetector(const rapidjson::Document &mRoverConfig);    
     //takes detected AR tag and finds center coordinate for use with ZED                                                                 
     Point2f getAverageTagCoordinateFromCorners(const vector<Point2f> &corners);
-    //detects AR tags in a given Mat     
-    pair<Tag, Tag> findARTags(Mat &src, Mat &depth_src, Mat &rgb);    
+    //detects AR tags in a given Mat and updates the tracks with them
+    //captureNs is when the frame was captured, so rates don't depend on how long detection took
+    void findARTags(Mat &src, Mat &depth_src, Mat &rgb, int64_t captureNs);
+    //estimates depth from every valid pixel inside a tag's corners, NaN if too few were valid
+    //confidence is the fraction of the tag whose depth agrees with the estimate
+    float estimateTagDepth(const Mat &depth_img, const vector<Point2f> &tagCorners, float &confidence);
     //finds the angle from center given pixel coordinates              
     double getAngle(float xPixel, float wPixel);     
-    //if AR tag found, updates distance, bearing, and id                              
-    void updateDetectedTagInfo(rover_msgs::Target *arTags, pair<Tag, Tag> &tagPair, Mat &depth_img, Mat &src); 
+    //fills both targets from the tracks, leftmost first, and DEFAULT_TAG_VAL where there is no tag
+    //held tags are predicted to the capture time of the last frame passed to findARTags
+    void updateDetectedTagInfo(rover_msgs::Target *arTags); 
+    //draws the tags found in the last frame on an image scaled by scale from it
+    void drawTags(Mat &image, double scale) const;
     
 };
@@ -0,0 +1,221 @@
+#include "perception.hpp"
+#include "frame_bundle.hpp"
+#include "stage_stats.hpp"
+#include "rover_msgs/TargetList.hpp"
+#include "rapidjson/ostreamwrapper.h"
+#include "rapidjson/prettywriter.h"
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+
+/* --- Perception Benchmark --- */
+//Replays a frame bundle through TagDetector and PCL on one thread, frame after frame,
+//so every run of the same bundle does exactly the same work
+//Prints per stage and end to end latency percentiles and frames per second as JSON
+//Run from the repository root so TagDetector finds jetson/percep/alvar_dict.yml
+
+#if PERCEPTION_DEBUG
+    #error "the benchmark would time perception_debug windows and prints, build it with perception_debug=false"
+#endif
+
+//Stages timed by the benchmark itself, obstacle stages come from PCL's own stats
+enum BenchStage {
+    FIND_AR_TAGS_STAGE,
+    UPDATE_TARGETS_STAGE,
+    OBSTACLE_DETECTION_STAGE,
+    FRAME_TOTAL_STAGE,
+    NUM_BENCH_STAGES
+};
+
+static void usage() {
+    cerr << "usage: jetson_percep_bench <frames.bundle> [--config <config.json>] "
+            "[--frames <n>] [--warmup <n>] [--output <results.json>]\n";
+}
+
+//Appends one object per stage of stats to writer
+template <typename Writer>
+static void writeStages(Writer &writer, const rover_msgs::PerceptionStats &stats, const vector<double> &meanMs) {
+    for (int i = 0; i < stats.num_stages; ++i) {
+        writer.Key(stats.stage_names[i].c_str());
+        writer.StartObject();
+        writer.Key("samples"); writer.Int(stats.samples[i]);
+        writer.Key("mean_ms"); writer.Double(meanMs[i]);
+        writer.Key("p50_ms"); writer.Double(stats.p50_ms[i]);
+        writer.Key("p95_ms"); writer.Double(stats.p95_ms[i]);
+        writer.Key("p99_ms"); writer.Double(stats.p99_ms[i]);
+        writer.Key("max_ms"); writer.Double(stats.max_ms[i]);
+        writer.Key("fps"); writer.Double(meanMs[i] > 0 ? 1000.0 / meanMs[i] : 0);
+        writer.EndObject();
+    }
+}
+
+//Parses a whole non-negative number, false if text is anything else
+static bool parseCount(const char *text, long &count) {
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value < 0) return false;
+    count = value;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    /* --- Arguments --- */
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    string bundlePath = argv[1];
+    string configPath = getenv("MROVER_CONFIG") ? string(getenv("MROVER_CONFIG")) + "/config_percep/config.json" : "";
+    string outputPath;
+    long maxFrames = -1;
+    long warmup = 5;
+    for (int i = 2; i < argc; i += 2) {
+        string flag = argv[i];
+        if (i + 1 == argc) {
+            cerr << flag << " needs a value\n";
+            usage();
+            return 1;
+        }
+        bool valid = true;
+        if (flag == "--config") configPath = argv[i + 1];
+        else if (flag == "--frames") valid = parseCount(argv[i + 1], maxFrames);
+        else if (flag == "--warmup") valid = parseCount(argv[i + 1], warmup);
+        else if (flag == "--output") outputPath = argv[i + 1];
+        else valid = false;
+        if (!valid) {
+            usage();
+            return 1;
+        }
+    }
+
+    //Opened before the run so a bad path doesn't throw away a long benchmark
+    ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        if (!outputFile.is_open()) {
+            cerr << "could not open output " << outputPath << "\n";
+            return 1;
+        }
+    }
+
+    FrameBundleReader bundle(bundlePath);
+    long frames = bundle.size();
+    if (maxFrames >= 0) frames = min(frames, warmup + maxFrames);
+    if (frames <= warmup) {
+        cerr << bundlePath << " has " << bundle.size() << " frames, not enough for " << warmup << " warmup frames\n";
+        return 1;
+    }
+    long measured = frames - warmup;
+
+    /* --- Config --- */
+    ifstream configFile(configPath);
+    if (!configFile) {
+        cerr << "could not open config " << configPath << "\n";
+        return 1;
+    }
+    stringstream contents;
+    contents << configFile.rdbuf();
+    rapidjson::Document mRoverConfig;
+    mRoverConfig.Parse(contents.str().c_str());
+    if (mRoverConfig.HasParseError()) {
+        cerr << "could not parse config " << configPath << "\n";
+        return 1;
+    }
+    //Windows hold exactly the measured frames, warmup samples are pushed out of the ring
+    mRoverConfig["stats"]["window"].SetInt(measured);
+
+    /* --- Detectors --- */
+    #if AR_DETECTION
+    TagDetector detector(mRoverConfig);
+    rover_msgs::Target arTags[2];
+    #endif
+    #if OBSTACLE_DETECTION
+    PCL pointcloud(mRoverConfig);
+    PointBuffer points(pointcloud.PT_CLOUD_WIDTH, pointcloud.PT_CLOUD_HEIGHT);
+    #endif
+
+    StageStats stats({"FindARTags", "UpdateTargets", "ObstacleDetection", "Frame"},
+                     measured, mRoverConfig["stats"]["publish_interval_ms"].GetInt());
+    long framesWithTarget = 0;
+    long framesWithObstacle = 0;
+
+    /* --- Replay --- */
+    auto runStart = chrono::steady_clock::now();
+    for (long frame = 0; frame < frames; ++frame) {
+        //Warmup frames fill caches and let the ground plane lock on
+        if (frame == warmup) {
+            framesWithTarget = framesWithObstacle = 0;
+            runStart = chrono::steady_clock::now();
+        }
+
+        //Copies like the capture stage does, the mapping is not part of what is measured
+        Mat src = bundle.rgb(frame).clone();
+        Mat depth = bundle.depth(frame).clone();
+        #if OBSTACLE_DETECTION
+        bundle.points(frame, points);
+        #endif
+
+        StageClock clock(stats);
+
+        #if AR_DETECTION
+        Mat rgb;
+        detector.findARTags(src, depth, rgb, bundle.timestamp(frame));
+        clock.lap(FIND_AR_TAGS_STAGE);
+        detector.updateDetectedTagInfo(arTags);
+        clock.lap(UPDATE_TARGETS_STAGE);
+        framesWithTarget += arTags[0].id != detector.DEFAULT_TAG_VAL;
+        #endif
+
+        #if OBSTACLE_DETECTION
+        pointcloud.pcl_obstacle_detection(points, bundle.timestamp(frame));
+        clock.lap(OBSTACLE_DETECTION_STAGE);
+        framesWithObstacle += pointcloud.distance >= 0;
+        #endif
+
+        clock.total(FRAME_TOTAL_STAGE);
+    }
+    double runSeconds = chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+
+    /* --- Results --- */
+    rover_msgs::PerceptionStats benchStats;
+    stats.fill(benchStats);
+
+    ostream &output = outputPath.empty() ? cout : outputFile;
+    rapidjson::OStreamWrapper stream(output);
+    rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(stream);
+
+    writer.StartObject();
+    writer.Key("bundle"); writer.String(bundlePath.c_str());
+    writer.Key("frames"); writer.Int64(measured);
+    writer.Key("warmup_frames"); writer.Int64(warmup);
+    writer.Key("seconds"); writer.Double(runSeconds);
+    writer.Key("fps"); writer.Double(measured / runSeconds);
+    writer.Key("stages");
+    writer.StartObject();
+    writeStages(writer, benchStats, stats.means());
+    #if OBSTACLE_DETECTION
+    //PCL already times each of its stages, reuse its windows
+    rover_msgs::PerceptionStats obstacleStats;
+    pointcloud.stats.fill(obstacleStats);
+    writeStages(writer, obstacleStats, pointcloud.stats.means());
+    #endif
+    writer.EndObject();
+    //Outputs are counted so a run that got faster by detecting less stands out in a diff
+    writer.Key("outputs");
+    writer.StartObject();
+    writer.Key("frames_with_target"); writer.Int64(framesWithTarget);
+    writer.Key("frames_with_obstacle"); writer.Int64(framesWithObstacle);
+    writer.EndObject();
+    writer.EndObject();
+    output << "\n";
+    output.flush();
+    if (!output) {
+        cerr << "could not write results to " << (outputPath.empty() ? "stdout" : outputPath) << "\n";
+        return 1;
+    }
+
+    return 0;
+}
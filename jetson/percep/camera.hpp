@@ -1,15 +1,21 @@
 #pragma once
 #include "perception.hpp"
+#include "point_buffer.hpp"
+#include "frame_recorder.hpp"
+#include "frame_bundle.hpp"
+#include "camera_backends.hpp"
 #include "rapidjson/document.h"
 
 #if OBSTACLE_DETECTION
 	#include <pcl/common/common_headers.h>
 #endif
 
+//Frames come from Backend, see camera_backends.hpp
+//Recording works the same whichever backend is used
+template <typename Backend>
 class Camera {
 private:
-	class Impl;
-	Impl *impl_;
+	Backend backend_;
 	std::string rgb_foldername;
 	std::string depth_foldername;
 	std::string pcl_foldername;
@@ -17,29 +23,75 @@ private:
 
     //reference to config file
     const rapidjson::Document& mRoverConfig;
+
+	//Set when recording to a frame bundle instead of a folder of files
+	std::unique_ptr<FrameBundleWriter> bundleWriter;
+
+	//Declared last so queued writes finish while the members they use are still alive
+	std::unique_ptr<FrameRecorder> diskRecorder;
+	std::unique_ptr<FrameRecorder> arRecorder;
 	
 public:
 
 	int FRAME_WRITE_INTERVAL;
+	size_t RECORD_QUEUE_CAPACITY;
+	bool RECORD_COMPRESS;
+	bool RECORD_BUNDLE;
+
+	//backendArgs follow config to the backend's constructor
+	template <typename... BackendArgs>
+	Camera(const rapidjson::Document &config, BackendArgs&&... backendArgs) :
+		backend_(config, std::forward<BackendArgs>(backendArgs)...), mRoverConfig( config ),
+		FRAME_WRITE_INTERVAL{mRoverConfig["camera"]["frame_write_interval"].GetInt()},
+		RECORD_QUEUE_CAPACITY{(size_t)mRoverConfig["camera"]["record_queue_capacity"].GetInt()},
+		RECORD_COMPRESS{!!mRoverConfig["camera"]["record_compress"].GetInt()},
+		RECORD_BUNDLE{!!mRoverConfig["camera"]["record_bundle"].GetInt()} {}
+
+	bool grab() {
+		return backend_.grab();
+	}
 
-	Camera(const rapidjson::Document &config);
-	~Camera();
+	//System clock in ns when the grabbed frame was captured
+	int64_t timestamp() {
+		return backend_.timestamp();
+	}
 
-	bool grab();
+	//System clock in ns when the scene in the grabbed frame was captured, the
+	//recording's own time on a replay, used for anything that depends on time between frames
+	int64_t sceneTimestamp() {
+		return backend_.sceneTimestamp();
+	}
 
-	cv::Mat image();
-	cv::Mat depth();
+	//Makes frame the next one grabbed, returns false unless replaying a frame bundle
+	bool seek(size_t frame) {
+		return backend_.seek(frame);
+	}
+
+	#if AR_DETECTION
+	cv::Mat image() {
+		return backend_.image();
+	}
+
+	cv::Mat depth() {
+		return backend_.depth();
+	}
+	#endif
 	
 	#if OBSTACLE_DETECTION
-	void getDataCloud(pcl::PointCloud<pcl::PointXYZRGB>::Ptr &p_pcl_point_cloud);
+	void getDataCloud(PointBuffer &points) {
+		backend_.dataCloud(points);
+	}
 	#endif
 
 	#if WRITE_CURR_FRAME_TO_DISK && AR_DETECTION && OBSTACLE_DETECTION
 	void disk_record_init();
-	void write_curr_frame_to_disk(cv::Mat rgb, cv::Mat depth, pcl::PointCloud<pcl::PointXYZRGB>::Ptr &p_pcl_point_cloud, int counter);
+	void disk_record_finish();
+	void write_curr_frame_to_disk(cv::Mat rgb, cv::Mat depth, std::shared_ptr<const PointBuffer> points, int64_t timestampNs, int counter);
 	#endif
 
+	#if AR_RECORD
 	void record_ar_init();
 	void record_ar(cv::Mat rgb);
 	void record_ar_finish();
+	#endif
 };
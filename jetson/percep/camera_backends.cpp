@@ -0,0 +1,284 @@
+#include "camera_backends.hpp"
+#include "perception.hpp"
+#include <cassert>
+#include <cerrno>
+#include <unordered_set>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if ZED_SDK_PRESENT
+/* --- ZED Backend --- */
+ZedBackend::ZedBackend(const rapidjson::Document &config) : THRESHOLD_CONFIDENCE(config["camera"]["threshold_confidence"].GetDouble()) {
+	sl::InitParameters init_params;
+	init_params.camera_resolution = sl::RESOLUTION::HD720; // default: 720p
+	init_params.depth_mode = sl::DEPTH_MODE::PERFORMANCE;
+	init_params.coordinate_units = sl::UNIT::METER;
+	init_params.camera_fps = 15;
+	// TODO change this below?
+
+	assert(this->zed_.open() == sl::ERROR_CODE::SUCCESS);
+  
+    //Parameters for Positional Tracking
+    init_params.coordinate_system = sl::COORDINATE_SYSTEM::RIGHT_HANDED_Y_UP; // Use a right-handed Y-up coordinate system
+    this->zed_.setCameraSettings(sl::VIDEO_SETTINGS::BRIGHTNESS, 1);
+
+	this->runtime_params_.confidence_threshold = THRESHOLD_CONFIDENCE;
+	
+    #if PERCEPTION_DEBUG
+        std::cout<<"ZED init success\n";
+    #endif
+
+    this->runtime_params_.sensing_mode = sl::SENSING_MODE::STANDARD;
+
+	this->image_size_ = this->zed_.getCameraInformation().camera_resolution;
+	this->image_zed_.alloc(this->image_size_.width, this->image_size_.height,
+						   sl::MAT_TYPE::U8_C4);
+	this->image_ = cv::Mat(
+		this->image_size_.height, this->image_size_.width, CV_8UC4,
+		this->image_zed_.getPtr<sl::uchar1>(sl::MEM::CPU));
+	this->depth_zed_.alloc(this->image_size_.width, this->image_size_.height,
+		                   sl::MAT_TYPE::F32_C1);
+	this->depth_ = cv::Mat(
+		this->image_size_.height, this->image_size_.width, CV_32FC1,
+		this->depth_zed_.getPtr<sl::uchar1>(sl::MEM::CPU));
+}
+
+bool ZedBackend::grab() {
+    return this->zed_.grab() == sl::ERROR_CODE::SUCCESS;
+}
+
+int64_t ZedBackend::timestamp() {
+    return this->zed_.getTimestamp(sl::TIME_REFERENCE::IMAGE).getNanoseconds();
+}
+
+cv::Mat ZedBackend::image() {
+	this->zed_.retrieveImage(this->image_zed_, sl::VIEW::LEFT, sl::MEM::CPU,
+							 this->image_size_);
+	return this->image_;
+}
+
+cv::Mat ZedBackend::depth() {
+    this->zed_.retrieveMeasure(this->depth_zed_, sl::MEASURE::DEPTH,  sl::MEM::CPU,  this->image_size_);
+	return this->depth_;
+}
+
+ZedBackend::~ZedBackend() {
+    this->depth_zed_.free(sl::MEM::CPU);
+    this->image_zed_.free(sl::MEM::CPU);
+	this->zed_.close();
+}
+
+#if OBSTACLE_DETECTION
+void ZedBackend::dataCloud(PointBuffer &points) {
+    //Wrap the buffer so the ZED writes straight into it
+    //No allocation and no per point conversion, invalid points stay NaN
+    sl::Resolution cloud_res(points.width, points.height);
+    sl::Mat data_cloud(cloud_res, sl::MAT_TYPE::F32_C4, reinterpret_cast<sl::uchar1 *>(points.data.data()),
+                       points.width * 4 * sizeof(float), sl::MEM::CPU);
+    this->zed_.retrieveMeasure(data_cloud, sl::MEASURE::XYZRGBA, sl::MEM::CPU, cloud_res);
+}
+#endif
+
+#endif
+
+/* --- Offline Backend --- */
+OfflineBackend::~OfflineBackend() {
+    if (rgb_dir) closedir(rgb_dir);
+    if (depth_dir) closedir(depth_dir);
+    if (pcd_dir) closedir(pcd_dir);
+}
+
+OfflineBackend::OfflineBackend(const rapidjson::Document &config, const std::string &replayPath) : path{replayPath} {
+  
+    rgb_dir = depth_dir = pcd_dir = NULL;
+    grab_time_ns = 0;
+    if (path.empty()) {
+        std::cout<<"Please input the folder path (there should be a rgb and depth existing in this folder) or a frame bundle: ";
+        std::cin>>path;
+    }
+
+    //A single file is a frame bundle, everything is read straight from its mapping
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) == 0 && S_ISREG(path_stat.st_mode)) {
+        bundle.reset(new FrameBundleReader(path));
+        bundle_frame = -1;
+        std::cout<<"Replaying "<<bundle->size()<<" frames\n";
+        return;
+    }
+    #if AR_DETECTION
+    rgb_path = path + "/rgb";
+    depth_path = path + "/depth";
+    rgb_dir = opendir(rgb_path.c_str() );
+    depth_dir = opendir(depth_path.c_str() );
+    if ( NULL==rgb_dir || NULL==depth_dir) {
+        return;
+    }
+
+    #endif  
+
+    #if OBSTACLE_DETECTION
+    pcd_path = path + "/pcl";
+    pcd_dir = opendir(pcd_path.c_str() );
+    if(NULL==pcd_dir) {
+        std::cerr<<"Input folder not exist\n";   
+        return;
+  }
+  #endif
+  
+
+    // get the vector of image names, jpg/png for rgb files, .exr for depth files
+    // we only read the rgb folder, and assume that the depth folder's images have the same name
+    struct dirent *dp = NULL;
+    #if AR_DETECTION
+  
+    std::unordered_set<std::string> img_tails({".exr", ".jpg", ".png"}); // for rgb
+    #if PERCEPTION_DEBUG
+        std::cout<<"Read image names\n";
+    #endif
+    do {
+        errno = 0;
+        if ((dp = readdir(rgb_dir)) != NULL) {
+        std::string file_name(dp->d_name);
+        #if PERCEPTION_DEBUG
+            std::cout<<"file_name is "<<file_name<<std::endl;
+        #endif
+        if (file_name.size() < 5) continue; // the lengh of the tail str is at least 4
+        std::string tail = file_name.substr(file_name.size()-4, 4);
+        std::string head = file_name.substr(0, file_name.size()-4);
+        if (img_tails.find(tail) != img_tails.end()) {
+            img_names.push_back(file_name);
+        }
+        }
+    } while  (dp != NULL);
+    std::sort(img_names.begin(), img_names.end());
+    #if PERCEPTION_DEBUG
+        std::cout<<"Read image names complete\n";
+    #endif
+    idx_curr_img = 0;
+
+    #endif
+
+#if OBSTACLE_DETECTION
+    dp = NULL;
+
+#if PERCEPTION_DEBUG
+    std::cout<<"Read PCL image names\n";
+#endif
+  
+do{
+    if ((dp = readdir(pcd_dir)) != NULL) {
+        std::string file_name(dp->d_name);
+        #if PERCEPTION_DEBUG
+            std::cout<<"file_name is "<<file_name<<std::endl;
+        #endif
+      
+        // the lengh of the tail str is at least 4
+        if (file_name.size() < 5) continue;
+
+        pcd_names.push_back(file_name);
+      
+    }
+
+} while (dp != NULL);
+
+    std::sort(pcd_names.begin(), pcd_names.end());
+    #if PERCEPTION_DEBUG
+        std::cout<<"Read .pcd image names complete\n";
+    #endif
+    idx_curr_pcd_img = 0;
+    
+#endif
+}
+
+bool OfflineBackend::grab() {
+    grab_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (bundle) {
+        if (bundle_frame + 1 >= (long)bundle->size()) {
+            std::cout<<"Ran out of images\n";
+            return false;
+        }
+        ++bundle_frame;
+        return true;
+    }
+
+    bool end = true;
+
+    #if AR_DETECTION
+    idx_curr_img++;
+    if (idx_curr_img >= img_names.size()) {
+        std::cout<<"Ran out of images\n";
+        end = false;
+    }
+    #endif
+
+    #if OBSTACLE_DETECTION
+    idx_curr_pcd_img++;
+    if (idx_curr_pcd_img >= pcd_names.size()-2) {
+        std::cout<<"Ran out of images\n";
+        end = false;  
+    }
+    #endif
+    if(!end){
+        exit(1);
+    }
+    return end;
+}
+
+bool OfflineBackend::seek(size_t frame) {
+    if (!bundle || frame >= bundle->size()) return false;
+    bundle_frame = (long)frame - 1;
+    return true;
+}
+
+#if AR_DETECTION
+cv::Mat OfflineBackend::image() {
+    if (bundle) return bundle->rgb(bundle_frame);
+    std::string full_path = rgb_path + std::string("/") + (img_names[idx_curr_img]);
+    #if PERCEPTION_DEBUG
+        cout << img_names[idx_curr_img] << "\n";
+        cout << full_path << "\n";
+    #endif
+    cv::Mat img = cv::imread(full_path.c_str(), CV_LOAD_IMAGE_COLOR);
+    if (!img.data){
+        std::cerr<<"Load image "<<full_path<< " error\n";
+    }
+    return img;
+}
+
+cv::Mat OfflineBackend::depth() {
+    if (bundle) return bundle->depth(bundle_frame);
+    std::string rgb_name = img_names[idx_curr_img];
+    std::string full_path = depth_path + std::string("/") +
+                            rgb_name.substr(0, rgb_name.size()-4) + std::string(".exr");
+    #if PERCEPTION_DEBUG
+        std::cout<<full_path<<std::endl;
+    #endif
+    cv::Mat img = cv::imread(full_path.c_str(), cv::IMREAD_ANYCOLOR | cv::IMREAD_ANYDEPTH);
+    if (!img.data){
+        std::cerr<<"Load image "<<full_path<< " error\n";
+    }
+    return img;
+}
+#endif
+
+
+//Reads the point data cloud p_pcl_point_cloud
+#if OBSTACLE_DETECTION
+void OfflineBackend::dataCloud(PointBuffer &points){
+ if (bundle) {
+    bundle->points(bundle_frame, points);
+    return;
+ }
+ 
+ //Read in image names
+ std::string pcd_name = pcd_names[idx_curr_pcd_img];
+ std::string full_path = pcd_path + std::string("/") + pcd_name;
+  //Load in the file  
+  if (pcl::io::loadPCDFile<pcl::PointXYZRGB> (full_path, pcd_cloud) == -1){ //* load the file 
+    PCL_ERROR ("Couldn't read file test_pcd.pcd \n"); 
+  }
+  cloudToPointBuffer(pcd_cloud, points);
+}
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+#include "config.h"
+#include "point_buffer.hpp"
+#include "frame_bundle.hpp"
+#include "rapidjson/document.h"
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+#if OBSTACLE_DETECTION
+    #include <pcl/point_cloud.h>
+    #include <pcl/point_types.h>
+#endif
+
+#if ZED_SDK_PRESENT
+    #include <sl/Camera.hpp>
+#endif
+
+//Camera backends are interchangeable sources of frames for Camera<Backend>
+//Each one provides grab(), timestamp(), sceneTimestamp(), image(), depth(), dataCloud() and seek(),
+//and LIVE, which is true if frames arrive at the sensor's own rate
+//The backend is a template parameter, so the one in use is called directly
+//and the code for every other backend never makes it into the pipeline
+
+#if ZED_SDK_PRESENT
+/* --- ZED Backend --- */
+//Abstracts away details of using Stereolab's camera interface
+//so we can just use a simple custom one
+class ZedBackend {
+public:
+    static const bool LIVE = true;
+
+    ZedBackend(const rapidjson::Document &config);
+    ~ZedBackend();
+    bool grab();
+
+    //System clock in ns when the grabbed frame was exposed
+    int64_t timestamp();
+
+    //Same as timestamp(), the scene is the one in front of the camera
+    int64_t sceneTimestamp() {
+        return timestamp();
+    }
+
+    cv::Mat image();
+    cv::Mat depth();
+
+    //constants
+    int THRESHOLD_CONFIDENCE;
+
+    #if OBSTACLE_DETECTION
+    void dataCloud(PointBuffer &points);
+    #endif
+
+    //A live camera can't seek
+    bool seek(size_t frame) {
+        return false;
+    }
+
+private:
+    sl::RuntimeParameters runtime_params_;
+    sl::Resolution image_size_;
+    sl::Camera zed_;
+
+    sl::Mat image_zed_;
+    sl::Mat depth_zed_;
+
+    cv::Mat image_;
+    cv::Mat depth_;
+};
+#endif
+
+/* --- Offline Backend --- */
+//Replays frames recorded with write_frame, either a folder of images or a frame bundle
+//Always built, so a build for the ZED can replay recordings as well
+class OfflineBackend {
+public:
+    static const bool LIVE = false;
+
+    //Asks for the folder or bundle on stdin if path is empty
+    OfflineBackend(const rapidjson::Document &config, const std::string &replayPath);
+    ~OfflineBackend();
+    bool grab();
+
+    //System clock in ns when the frame was grabbed, not when it was recorded,
+    //so latencies measured on a replay are those of the pipeline itself
+    int64_t timestamp() {
+        return grab_time_ns;
+    }
+
+    //System clock in ns when the frame was recorded, so time between frames
+    //is that of the recording however fast it is replayed
+    //Folders of images hold no capture times and fall back to timestamp()
+    int64_t sceneTimestamp() {
+        return bundle ? bundle->timestamp(bundle_frame) : grab_time_ns;
+    }
+
+    //Makes frame the next one grabbed, only possible when replaying a bundle
+    bool seek(size_t frame);
+
+    #if AR_DETECTION
+    cv::Mat image();
+    cv::Mat depth();
+    #endif
+
+    #if OBSTACLE_DETECTION
+    void dataCloud(PointBuffer &points);
+    #endif
+
+private:
+    std::vector<std::string> img_names;
+    std::vector<std::string> pcd_names;
+
+    size_t idx_curr_img;
+    size_t idx_curr_pcd_img;
+
+    std::string path;
+    std::string rgb_path;
+    DIR * rgb_dir;
+    std::string depth_path;
+    DIR * depth_dir;
+    std::string pcd_path;
+    DIR * pcd_dir;
+
+    #if OBSTACLE_DETECTION
+    //Reused between frames to avoid reallocating on every load
+    pcl::PointCloud<pcl::PointXYZRGB> pcd_cloud;
+    #endif
+
+    //Set when replaying a frame bundle instead of a folder of images
+    std::unique_ptr<FrameBundleReader> bundle;
+    long bundle_frame;
+
+    int64_t grab_time_ns;
+};
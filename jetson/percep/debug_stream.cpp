@@ -0,0 +1,84 @@
+#include "debug_stream.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+static const int TOP_DOWN_HEIGHT = 480;
+static const double DEG_TO_RAD = M_PI / 180;
+
+//Cycled through by cluster so neighbouring obstacles stand apart
+static const cv::Scalar CLUSTER_COLORS[] = {
+    {255, 80, 80}, {80, 255, 80}, {80, 80, 255}, {255, 255, 80}, {255, 80, 255}, {80, 255, 255}
+};
+
+DebugViewer::DebugViewer(SnapshotRing<TagSnapshot> &tags, SnapshotRing<ObstacleSnapshot> &obstacles,
+                         double maxRangeMm, int fieldOfView, int refreshMs) :
+    tags_{tags}, obstacles_{obstacles}, maxRangeMm_{maxRangeMm}, fieldOfView_{fieldOfView},
+    refreshMs_{refreshMs}, topDown_{TOP_DOWN_HEIGHT, 2 * TOP_DOWN_HEIGHT, CV_8UC3}, running_{true} {}
+
+/* --- Run --- */
+//Only the newest snapshot of each kind is drawn, older ones are released unseen
+void DebugViewer::run() {
+    while (running_) {
+        auto start = std::chrono::steady_clock::now();
+
+        if (TagSnapshot *snapshot = tags_.beginRead()) {
+            cv::imshow("AR Tag Stream", snapshot->image);
+            tags_.endRead();
+        }
+
+        if (ObstacleSnapshot *snapshot = obstacles_.beginRead()) {
+            drawObstacles(*snapshot);
+            obstacles_.endRead();
+            cv::imshow("Obstacle Stream", topDown_);
+        }
+
+        //waitKey also pumps the window events
+        int elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        cv::waitKey(std::max(1, refreshMs_ - elapsedMs));
+    }
+
+    std::cout << "Debug stream snapshots skipped: " << tags_.dropped() << " AR tag, "
+              << obstacles_.dropped() << " obstacle" << std::endl;
+}
+
+/* --- Draw Obstacles --- */
+void DebugViewer::drawObstacles(const ObstacleSnapshot &snapshot) {
+    topDown_.setTo(cv::Scalar::all(0));
+    double pixelsPerMm = TOP_DOWN_HEIGHT / maxRangeMm_;
+    cv::Point2f rover(topDown_.cols / 2.0f, topDown_.rows - 1);
+
+    //Straight ahead from the rover at bearing degrees, right is positive
+    auto ray = [&](double bearing) {
+        double angle = bearing * DEG_TO_RAD;
+        return rover + cv::Point2f(std::sin(angle), -std::cos(angle)) * (float)(maxRangeMm_ * pixelsPerMm);
+    };
+
+    //Field of view
+    cv::line(topDown_, rover, ray(-fieldOfView_), cv::Scalar::all(90));
+    cv::line(topDown_, rover, ray(fieldOfView_), cv::Scalar::all(90));
+
+    for (size_t i = 0; i < snapshot.points.size(); ++i) {
+        const cv::Point2f &point = snapshot.points[i];
+        cv::Point2f pixel(rover.x + point.x * pixelsPerMm, rover.y - point.y * pixelsPerMm);
+        const cv::Scalar &color = CLUSTER_COLORS[snapshot.clusters[i] % (sizeof(CLUSTER_COLORS) / sizeof(CLUSTER_COLORS[0]))];
+        cv::circle(topDown_, pixel, 1, color, -1);
+    }
+
+    //Paths, a single white line if straight ahead is clear
+    if (snapshot.leftBearing == 0 && snapshot.rightBearing == 0) {
+        cv::line(topDown_, rover, ray(0), cv::Scalar::all(255), 2);
+    }
+    else {
+        cv::line(topDown_, rover, ray(snapshot.leftBearing), cv::Scalar(0, 255, 0), 2);
+        cv::line(topDown_, rover, ray(snapshot.rightBearing), cv::Scalar(0, 255, 0), 2);
+    }
+
+    std::string label = "frame " + std::to_string(snapshot.frame) + "  distance " + std::to_string(snapshot.distance) + " m";
+    cv::putText(topDown_, label, cv::Point(10, 20), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar::all(255));
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+/* --- Snapshot Ring --- */
+//Lock free ring between one producer and one consumer
+//Slots are allocated once and reused, so a producer that fills a slot's
+//containers in place stops allocating once the sizes settle
+//The producer never waits: if the consumer has fallen behind, beginWrite
+//returns null and the snapshot is skipped
+template <typename T>
+class SnapshotRing {
+public:
+    explicit SnapshotRing(size_t capacity) : slots_(capacity + 1), head_{0}, tail_{0}, dropped_{0} {}
+
+    //Producer: slot to fill, or null if every slot is waiting to be read
+    T *beginWrite() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (next(head) == tail_.load(std::memory_order_acquire)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots_[head];
+    }
+
+    //Producer: publishes the slot returned by beginWrite
+    void commitWrite() {
+        head_.store(next(head_.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    //Consumer: newest published slot, older ones are skipped, or null if there is none
+    T *beginRead() {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head) return nullptr;
+        size_t newest = (head + slots_.size() - 1) % slots_.size();
+        if (newest != tail) {
+            tail_.store(newest, std::memory_order_release);
+        }
+        return &slots_[newest];
+    }
+
+    //Consumer: hands the slot returned by beginRead back to the producer
+    void endRead() {
+        tail_.store(next(tail_.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    //Snapshots the producer skipped because the consumer was behind
+    size_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    size_t next(size_t index) const {
+        return (index + 1) % slots_.size();
+    }
+
+    std::vector<T> slots_;
+    std::atomic<size_t> head_;
+    std::atomic<size_t> tail_;
+    std::atomic<size_t> dropped_;
+};
+
+/* --- Snapshots --- */
+//Downsampled camera image with the detected tags drawn on it
+struct TagSnapshot {
+    int frame;
+    cv::Mat image;
+};
+
+//Clustered obstacle points seen from above, with the chosen path
+struct ObstacleSnapshot {
+    int frame;
+    std::vector<cv::Point2f> points; //x to the right and z ahead in mm, z is stored in y
+    std::vector<int> clusters; //cluster of each point
+    double leftBearing;
+    double rightBearing;
+    double distance;
+};
+
+/* --- Debug Viewer --- */
+//Renders the newest snapshots on its own thread at its own rate
+//This is the only thread that touches a window in debug stream mode,
+//meson.build turns perception_debug and its windows off when debug_stream is on
+class DebugViewer {
+public:
+    DebugViewer(SnapshotRing<TagSnapshot> &tags, SnapshotRing<ObstacleSnapshot> &obstacles,
+                double maxRangeMm, int fieldOfView, int refreshMs);
+
+    //Renders until stop() is called
+    void run();
+
+    void stop() {
+        running_ = false;
+    }
+
+private:
+    //Top down view with the rover at the bottom center
+    void drawObstacles(const ObstacleSnapshot &snapshot);
+
+    SnapshotRing<TagSnapshot> &tags_;
+    SnapshotRing<ObstacleSnapshot> &obstacles_;
+    double maxRangeMm_;
+    int fieldOfView_;
+    int refreshMs_;
+    cv::Mat topDown_;
+    std::atomic<bool> running_;
+};
@@ -0,0 +1,205 @@
+#include "frame_bundle.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t aligned(uint64_t bytes) {
+    return (bytes + BUNDLE_ALIGNMENT - 1) / BUNDLE_ALIGNMENT * BUNDLE_ALIGNMENT;
+}
+
+/* --- Frame Bundle Writer --- */
+FrameBundleWriter::FrameBundleWriter(const std::string &path) :
+    path_{path}, file_{std::fopen(path.c_str(), "wb")}, failed_{false}, position_{0} {
+    if (!file_) {
+        throw std::runtime_error("could not open " + path + ": " + std::strerror(errno));
+    }
+    BundleFileHeader header = {BUNDLE_MAGIC, BUNDLE_VERSION};
+    writeAligned(&header, sizeof(header));
+}
+
+FrameBundleWriter::~FrameBundleWriter() {
+    // the index itself needs no padding, it is only ever found through the trailer
+    // after a failure the last record may be torn, so it is left for the reader to walk
+    if (!failed_) {
+        BundleTrailer trailer = {position_, offsets_.size(), BUNDLE_INDEX_MAGIC, BUNDLE_VERSION};
+        if (std::fwrite(offsets_.data(), sizeof(uint64_t), offsets_.size(), file_) != offsets_.size() ||
+            std::fwrite(&trailer, sizeof(trailer), 1, file_) != 1) {
+            fail();
+        }
+    }
+    if (std::fclose(file_) != 0) fail();
+}
+
+void FrameBundleWriter::fail() {
+    if (!failed_) {
+        std::cerr << "Frame bundle " << path_ << " stopped recording: " << std::strerror(errno) << std::endl;
+    }
+    failed_ = true;
+}
+
+void FrameBundleWriter::writeAligned(const void *data, size_t bytes) {
+    static const char zeros[BUNDLE_ALIGNMENT] = {};
+    if (failed_) return;
+    size_t padding = aligned(bytes) - bytes;
+    if (std::fwrite(data, 1, bytes, file_) != bytes || std::fwrite(zeros, 1, padding, file_) != padding) {
+        fail();
+        return;
+    }
+    position_ += bytes + padding;
+}
+
+void FrameBundleWriter::append(const cv::Mat &rgb, const cv::Mat &depth, const PointBuffer *points, int64_t timestampNs) {
+    if (failed_) return;
+
+    // payloads are written as one block each, which needs continuous images
+    cv::Mat rgbData = rgb.isContinuous() ? rgb : rgb.clone();
+    cv::Mat depthData = depth.isContinuous() ? depth : depth.clone();
+
+    BundleRecordHeader header = {};
+    header.magic = BUNDLE_RECORD_MAGIC;
+    header.index = offsets_.size();
+    header.timestampNs = timestampNs;
+    header.rgbRows = rgbData.rows;
+    header.rgbCols = rgbData.cols;
+    header.rgbType = rgbData.type();
+    header.rgbBytes = rgbData.total() * rgbData.elemSize();
+    header.depthRows = depthData.rows;
+    header.depthCols = depthData.cols;
+    header.depthType = depthData.type();
+    header.depthBytes = depthData.total() * depthData.elemSize();
+    header.cloudWidth = points ? points->width : 0;
+    header.cloudHeight = points ? points->height : 0;
+    header.cloudBytes = points ? points->data.size() * sizeof(float) : 0;
+
+    offsets_.push_back(position_);
+    writeAligned(&header, sizeof(header));
+    writeAligned(rgbData.data, header.rgbBytes);
+    writeAligned(depthData.data, header.depthBytes);
+    writeAligned(points ? points->data.data() : nullptr, header.cloudBytes);
+}
+
+/* --- Frame Bundle Reader --- */
+FrameBundleReader::FrameBundleReader(const std::string &path) : fd_{-1}, data_{nullptr}, length_{0} {
+    fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd_ < 0 || fstat(fd_, &st) < 0) {
+        if (fd_ >= 0) close(fd_);
+        throw std::runtime_error("could not open " + path + ": " + std::strerror(errno));
+    }
+    length_ = st.st_size;
+    if (length_ < sizeof(BundleFileHeader)) {
+        close(fd_);
+        throw std::runtime_error(path + " is not a frame bundle");
+    }
+
+    void *mapping = mmap(nullptr, length_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED) {
+        close(fd_);
+        throw std::runtime_error("could not map " + path + ": " + std::strerror(errno));
+    }
+    data_ = static_cast<uint8_t *>(mapping);
+
+    const BundleFileHeader &header = *reinterpret_cast<const BundleFileHeader *>(data_);
+    if (header.magic != BUNDLE_MAGIC || header.version != BUNDLE_VERSION) {
+        munmap(data_, length_);
+        close(fd_);
+        throw std::runtime_error(path + " is not a version " + std::to_string(BUNDLE_VERSION) + " frame bundle");
+    }
+    // the destructor won't run if the constructor throws
+    try {
+        readIndex();
+    } catch (...) {
+        munmap(data_, length_);
+        close(fd_);
+        throw;
+    }
+}
+
+FrameBundleReader::~FrameBundleReader() {
+    munmap(data_, length_);
+    close(fd_);
+}
+
+//True if a rows by cols image of type fits in bytes, so a Mat over the payload stays inside it
+static bool validImage(int32_t rows, int32_t cols, int32_t type, uint64_t bytes) {
+    if (rows < 0 || cols < 0 || type < 0 || type != CV_MAT_TYPE(type)) return false;
+    return (uint64_t)rows * cols <= bytes / CV_ELEM_SIZE(type);
+}
+
+bool FrameBundleReader::validRecord(uint64_t offset) const {
+    if (offset % BUNDLE_ALIGNMENT || offset + sizeof(BundleRecordHeader) > length_) return false;
+    const BundleRecordHeader &header = *reinterpret_cast<const BundleRecordHeader *>(data_ + offset);
+    // a torn or garbage header could hold sizes that overflow the sum below
+    if (header.rgbBytes > length_ || header.depthBytes > length_ || header.cloudBytes > length_) return false;
+    if (!validImage(header.rgbRows, header.rgbCols, header.rgbType, header.rgbBytes) ||
+        !validImage(header.depthRows, header.depthCols, header.depthType, header.depthBytes) ||
+        !validImage(header.cloudWidth, header.cloudHeight, CV_32FC4, header.cloudBytes)) {
+        return false;
+    }
+    uint64_t end = offset + aligned(sizeof(header)) + aligned(header.rgbBytes) +
+                   aligned(header.depthBytes) + aligned(header.cloudBytes);
+    return header.magic == BUNDLE_RECORD_MAGIC && end <= length_;
+}
+
+void FrameBundleReader::readIndex() {
+    if (length_ >= sizeof(BundleTrailer)) {
+        const BundleTrailer &trailer = *reinterpret_cast<const BundleTrailer *>(data_ + length_ - sizeof(BundleTrailer));
+        bool indexed = trailer.magic == BUNDLE_INDEX_MAGIC &&
+                       trailer.indexOffset + trailer.count * sizeof(uint64_t) + sizeof(BundleTrailer) == length_;
+        if (indexed) {
+            const uint64_t *offsets = reinterpret_cast<const uint64_t *>(data_ + trailer.indexOffset);
+            offsets_.assign(offsets, offsets + trailer.count);
+            for (uint64_t offset : offsets_) {
+                if (!validRecord(offset)) throw std::runtime_error("frame bundle index is corrupt");
+            }
+            return;
+        }
+    }
+
+    // no index, the writer never closed; keep every record that was written in full
+    uint64_t offset = aligned(sizeof(BundleFileHeader));
+    while (validRecord(offset)) {
+        offsets_.push_back(offset);
+        const BundleRecordHeader &header = record(offsets_.size() - 1);
+        offset += aligned(sizeof(header)) + aligned(header.rgbBytes) +
+                  aligned(header.depthBytes) + aligned(header.cloudBytes);
+    }
+}
+
+const BundleRecordHeader &FrameBundleReader::record(size_t frame) const {
+    return *reinterpret_cast<const BundleRecordHeader *>(data_ + offsets_.at(frame));
+}
+
+uint8_t *FrameBundleReader::payload(size_t frame) const {
+    return data_ + offsets_.at(frame) + aligned(sizeof(BundleRecordHeader));
+}
+
+int64_t FrameBundleReader::timestamp(size_t frame) const {
+    return record(frame).timestampNs;
+}
+
+cv::Mat FrameBundleReader::rgb(size_t frame) const {
+    const BundleRecordHeader &header = record(frame);
+    if (!header.rgbBytes) return cv::Mat();
+    return cv::Mat(header.rgbRows, header.rgbCols, header.rgbType, payload(frame));
+}
+
+cv::Mat FrameBundleReader::depth(size_t frame) const {
+    const BundleRecordHeader &header = record(frame);
+    if (!header.depthBytes) return cv::Mat();
+    return cv::Mat(header.depthRows, header.depthCols, header.depthType,
+                   payload(frame) + aligned(header.rgbBytes));
+}
+
+void FrameBundleReader::points(size_t frame, PointBuffer &points) const {
+    const BundleRecordHeader &header = record(frame);
+    points.resize(header.cloudWidth, header.cloudHeight);
+    std::memcpy(points.data.data(), payload(frame) + aligned(header.rgbBytes) + aligned(header.depthBytes),
+                std::min<size_t>(header.cloudBytes, points.data.size() * sizeof(float)));
+}
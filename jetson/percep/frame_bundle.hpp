@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include "point_buffer.hpp"
+
+/* --- Frame Bundle --- */
+//Single file recording of synchronized frames for offline replay
+//
+//Layout:
+//  BundleFileHeader
+//  one record per frame: BundleRecordHeader, RGB pixels, depth pixels, XYZRGBA points
+//  offsets of every record, then a BundleTrailer
+//
+//Every header and payload starts on a BUNDLE_ALIGNMENT boundary so a reader can map
+//the file and hand out images that point straight into it
+//Records are only ever appended, the index is written when the writer is closed
+//A file without an index, e.g. after a crash, is indexed by walking the record headers
+
+const uint32_t BUNDLE_MAGIC = 0x4246524d; //"MRFB"
+const uint32_t BUNDLE_RECORD_MAGIC = 0x454d5246; //"FRME"
+const uint32_t BUNDLE_INDEX_MAGIC = 0x58444e49; //"INDX"
+const uint32_t BUNDLE_VERSION = 1;
+const size_t BUNDLE_ALIGNMENT = 64;
+
+struct BundleFileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct BundleRecordHeader {
+    uint32_t magic;
+    uint32_t index;
+    int64_t timestampNs; //system clock at capture
+    int32_t rgbRows, rgbCols, rgbType;
+    int32_t depthRows, depthCols, depthType;
+    int32_t cloudWidth, cloudHeight;
+    uint64_t rgbBytes, depthBytes, cloudBytes;
+};
+
+struct BundleTrailer {
+    uint64_t indexOffset;
+    uint64_t count;
+    uint32_t magic;
+    uint32_t version;
+};
+
+/* --- Frame Bundle Writer --- */
+class FrameBundleWriter {
+public:
+    //Creates or truncates path, throws std::runtime_error if it can't be opened
+    FrameBundleWriter(const std::string &path);
+
+    //Writes the index so readers don't have to walk the file
+    ~FrameBundleWriter();
+
+    //Appends one frame, any of the images may be empty and points may be null
+    //After a failed write nothing more is appended and no index is written,
+    //the reader then keeps the records that made it to disk in full
+    void append(const cv::Mat &rgb, const cv::Mat &depth, const PointBuffer *points, int64_t timestampNs);
+
+    size_t size() const {
+        return offsets_.size();
+    }
+
+private:
+    //Writes bytes and pads with zeros up to the next BUNDLE_ALIGNMENT boundary
+    void writeAligned(const void *data, size_t bytes);
+
+    //Reports the first failure, later ones are expected and stay quiet
+    void fail();
+
+    std::string path_;
+    std::FILE *file_;
+    bool failed_;
+    uint64_t position_;
+    std::vector<uint64_t> offsets_;
+};
+
+/* --- Frame Bundle Reader --- */
+//Memory maps a bundle for random access by frame index
+//Images returned point into the mapping and are valid for the reader's lifetime
+//The mapping is private, so writing to them never touches the file
+class FrameBundleReader {
+public:
+    //Throws std::runtime_error if path is not a bundle
+    FrameBundleReader(const std::string &path);
+
+    ~FrameBundleReader();
+
+    FrameBundleReader(const FrameBundleReader &) = delete;
+    FrameBundleReader &operator=(const FrameBundleReader &) = delete;
+
+    size_t size() const {
+        return offsets_.size();
+    }
+
+    int64_t timestamp(size_t frame) const;
+
+    cv::Mat rgb(size_t frame) const;
+
+    cv::Mat depth(size_t frame) const;
+
+    //Copies the frame's points into points, resizing it if needed
+    void points(size_t frame, PointBuffer &points) const;
+
+private:
+    const BundleRecordHeader &record(size_t frame) const;
+
+    //Start of the payload that follows the record header
+    uint8_t *payload(size_t frame) const;
+
+    //Offsets from the trailer, or from walking the records if there is none
+    void readIndex();
+
+    //True if a whole record fits in the file at offset
+    bool validRecord(uint64_t offset) const;
+
+    int fd_;
+    uint8_t *data_;
+    size_t length_;
+    std::vector<uint64_t> offsets_;
+};
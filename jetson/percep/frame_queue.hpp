@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/* --- Frame Queue --- */
+//Bounded queue used to hand frames from one pipeline stage to the next
+//There is exactly one producer and one consumer per queue
+//When the queue is full the producer either blocks until the consumer catches up
+//or, with dropOldest set, throws away the stalest frame so consumers always see recent data
+template <typename T>
+class FrameQueue {
+public:
+    FrameQueue(size_t capacity, bool dropOldest) :
+        capacity_{capacity ? capacity : 1}, dropOldest_{dropOldest}, closed_{false}, dropped_{0} {}
+
+    //Adds an item to the back of the queue
+    //Returns false if the queue has been closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!dropOldest_) {
+            notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        }
+        if (closed_) {
+            return false;
+        }
+        if (items_.size() >= capacity_) {
+            items_.pop_front();
+            ++dropped_;
+        }
+        items_.push_back(std::move(item));
+        lock.unlock();
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    //Removes the item at the front of the queue, blocking until one is available
+    //Returns false once the queue is closed and fully drained
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        notFull_.notify_one();
+        return true;
+    }
+
+    //Wakes up both ends of the queue, no further items are accepted
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    //Number of frames thrown away because the consumer fell behind
+    size_t dropped() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+private:
+    const size_t capacity_;
+    const bool dropOldest_;
+    bool closed_;
+    size_t dropped_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "frame_queue.hpp"
+
+/* --- Frame Recorder --- */
+//Runs the disk writes for recording on a background thread so they never stall detection
+//Jobs capture the frame's reference counted buffers (cv::Mat, pooled PointBuffer),
+//so queueing a frame copies no pixels and the buffers go back to their pool once written
+//When the disk falls behind the oldest pending job is dropped and counted
+class FrameRecorder {
+public:
+    FrameRecorder(const std::string &name, size_t capacity) :
+        name_{name}, jobs_{capacity, true}, writer_{&FrameRecorder::write, this} {}
+
+    //Finishes every queued job before returning
+    ~FrameRecorder() {
+        jobs_.close();
+        writer_.join();
+        if (jobs_.dropped()) {
+            std::cerr << name_ << " recorder dropped " << jobs_.dropped() << " frames" << std::endl;
+        }
+    }
+
+    //Queues a write, called from a single producer thread
+    void submit(std::function<void()> job) {
+        jobs_.push(std::move(job));
+    }
+
+    //Number of frames that were never written because the queue was full
+    size_t dropped() {
+        return jobs_.dropped();
+    }
+
+private:
+    void write() {
+        std::function<void()> job;
+        while (jobs_.pop(job)) {
+            job();
+        }
+    }
+
+    std::string name_;
+    FrameQueue<std::function<void()>> jobs_;
+    std::thread writer_;
+};
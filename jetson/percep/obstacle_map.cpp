@@ -0,0 +1,123 @@
+#include "obstacle_map.hpp"
+#include <algorithm>
+#include <cmath>
+
+static const double EARTH_RADIUS_MM = 6371000000.0;
+static const double DEG_TO_RAD = M_PI / 180;
+
+/* --- Odometry Tracker --- */
+//Latitude and longitude are projected onto a plane through the first fix,
+//which is accurate to well under a cell over the distances of a course
+void OdometryTracker::handle(const lcm::ReceiveBuffer *buffer, const std::string &channel,
+                             const rover_msgs::Odometry *odometry) {
+    double latitude = odometry->latitude_deg + odometry->latitude_min / 60;
+    double longitude = odometry->longitude_deg + odometry->longitude_min / 60;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!anchored_) {
+        originLatitude_ = latitude;
+        originLongitude_ = longitude;
+        mmPerLongitudeDegree_ = EARTH_RADIUS_MM * DEG_TO_RAD * std::cos(latitude * DEG_TO_RAD);
+        anchored_ = true;
+    }
+    pose_.north = (latitude - originLatitude_) * EARTH_RADIUS_MM * DEG_TO_RAD;
+    pose_.east = (longitude - originLongitude_) * mmPerLongitudeDegree_;
+    pose_.heading = odometry->bearing_deg;
+}
+
+/* --- Obstacle Map --- */
+ObstacleMap::ObstacleMap(const rapidjson::Value &fusion) :
+
+    //Populate Constants from Config File
+    CELL_SIZE{fusion["cell_size"].GetDouble()},
+    GRID_CELLS{fusion["grid_cells"].GetInt()},
+    HIT_EVIDENCE{fusion["hit_evidence"].GetDouble()},
+    MISS_EVIDENCE{fusion["miss_evidence"].GetDouble()},
+    MAX_EVIDENCE{fusion["max_evidence"].GetDouble()},
+    CONFIRM_EVIDENCE{fusion["confirm_evidence"].GetDouble()},
+    RELEASE_EVIDENCE{fusion["release_evidence"].GetDouble()},
+    DECAY_S{fusion["decay_s"].GetDouble()},
+
+    cells(GRID_CELLS * GRID_CELLS), pose{0, 0, 0}, sinHeading{0}, cosHeading{1}, frame{0} {
+
+    clear();
+}
+
+void ObstacleMap::clear() {
+    //Every slot starts out claimed by a cell no point can map to
+    for (Cell &cell : cells) {
+        cell = Cell{INT32_MIN, INT32_MIN, 0, 0, false};
+    }
+}
+
+ObstacleMap::Cell &ObstacleMap::slot(int32_t x, int32_t y) {
+    int32_t column = ((x % GRID_CELLS) + GRID_CELLS) % GRID_CELLS;
+    int32_t row = ((y % GRID_CELLS) + GRID_CELLS) % GRID_CELLS;
+    return cells[row * GRID_CELLS + column];
+}
+
+void ObstacleMap::beginFrame(const RoverPose &roverPose, double dt) {
+    pose = roverPose;
+    sinHeading = std::sin(pose.heading * DEG_TO_RAD);
+    cosHeading = std::cos(pose.heading * DEG_TO_RAD);
+    ++frame;
+
+    float decay = std::exp(-std::max(dt, 0.0) / DECAY_S);
+    for (Cell &cell : cells) {
+        cell.evidence *= decay;
+    }
+}
+
+void ObstacleMap::addPoint(float x, float z) {
+    //Rover frame to ground: z points along the heading, x to its right
+    double east = pose.east + x * cosHeading + z * sinHeading;
+    double north = pose.north - x * sinHeading + z * cosHeading;
+    int32_t cellX = (int32_t)std::floor(east / CELL_SIZE);
+    int32_t cellY = (int32_t)std::floor(north / CELL_SIZE);
+
+    Cell &cell = slot(cellX, cellY);
+    if (cell.x != cellX || cell.y != cellY) {
+        cell = Cell{cellX, cellY, 0, 0, false};
+    }
+    //A dense obstacle counts once per cell, so evidence measures frames, not points
+    if (cell.hitFrame != frame) {
+        cell.hitFrame = frame;
+        cell.evidence = std::min<float>(cell.evidence + HIT_EVIDENCE, MAX_EVIDENCE);
+    }
+}
+
+MapPoint ObstacleMap::toRover(const Cell &cell) const {
+    double east = (cell.x + 0.5) * CELL_SIZE - pose.east;
+    double north = (cell.y + 0.5) * CELL_SIZE - pose.north;
+    return MapPoint{(float)(east * cosHeading - north * sinHeading), (float)(east * sinHeading + north * cosHeading)};
+}
+
+bool ObstacleMap::inView(const MapPoint &point, double tanFieldOfView, double range) {
+    return point.z > 0 && point.z <= range && std::abs(point.x) <= point.z * tanFieldOfView;
+}
+
+void ObstacleMap::endFrame(double fieldOfView, double range) {
+    double tanFieldOfView = std::tan(fieldOfView * DEG_TO_RAD);
+    for (Cell &cell : cells) {
+        if (cell.evidence <= 0) continue;
+        if (cell.hitFrame != frame && inView(toRover(cell), tanFieldOfView, range)) {
+            cell.evidence = std::max<float>(cell.evidence - MISS_EVIDENCE, 0);
+        }
+        //Confirmed cells are only released well below the confirmation level,
+        //so an obstacle missed for a frame or two doesn't flicker
+        if (cell.evidence >= CONFIRM_EVIDENCE) cell.confirmed = true;
+        else if (cell.evidence < RELEASE_EVIDENCE) cell.confirmed = false;
+    }
+}
+
+void ObstacleMap::confirmed(double fieldOfView, double range, std::vector<MapPoint> &points) const {
+    double tanFieldOfView = std::tan(fieldOfView * DEG_TO_RAD);
+    points.clear();
+    for (const Cell &cell : cells) {
+        if (!cell.confirmed) continue;
+        MapPoint point = toRover(cell);
+        if (inView(point, tanFieldOfView, range)) {
+            points.push_back(point);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <lcm/lcm-cpp.hpp>
+#include "rapidjson/document.h"
+#include "rover_msgs/Odometry.hpp"
+
+/* --- Rover Pose --- */
+//Position in mm east and north of the first odometry fix, heading in degrees clockwise from north
+struct RoverPose {
+    double east;
+    double north;
+    double heading;
+};
+
+//Keeps the latest /odometry as a pose in a flat frame anchored at the first fix
+//LCM delivers on one thread while obstacle detection reads on another
+class OdometryTracker {
+public:
+    OdometryTracker() : pose_{0, 0, 0}, anchored_{false} {}
+
+    void handle(const lcm::ReceiveBuffer *buffer, const std::string &channel, const rover_msgs::Odometry *odometry);
+
+    //Origin facing north until the first fix arrives
+    RoverPose pose() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pose_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    RoverPose pose_;
+    bool anchored_;
+    double originLatitude_;
+    double originLongitude_;
+    double mmPerLongitudeDegree_;
+};
+
+/* --- Obstacle Map --- */
+//A point of a confirmed cell, in the rover frame: x to the right and z ahead in mm
+struct MapPoint {
+    float x, z;
+};
+
+//Square grid of obstacle evidence around the rover, fixed to the ground rather than the rover
+//Obstacles seen from a moving rover stay in their cells, so evidence from consecutive frames adds up
+//Each frame a hit cell gains HIT_EVIDENCE, a cell in view that was not hit loses MISS_EVIDENCE,
+//and all evidence decays with DECAY_S, so a cell is confirmed as soon as enough evidence has
+//built up rather than after a fixed number of frames, and stays confirmed until its evidence
+//falls below RELEASE_EVIDENCE
+//The grid wraps around, so cells left behind are reused for the ground the rover drives onto
+class ObstacleMap {
+public:
+    //Constants
+    double CELL_SIZE;
+    int GRID_CELLS;
+    double HIT_EVIDENCE;
+    double MISS_EVIDENCE;
+    double MAX_EVIDENCE;
+    double CONFIRM_EVIDENCE;
+    double RELEASE_EVIDENCE;
+    double DECAY_S;
+
+    //Reads pt_cloud/fusion
+    ObstacleMap(const rapidjson::Value &fusion);
+
+    //Moves to the rover's pose and decays everything by dt seconds
+    void beginFrame(const RoverPose &pose, double dt);
+
+    //Adds evidence for a point seen this frame, in the rover frame in mm
+    void addPoint(float x, float z);
+
+    //Takes evidence away from cells in view that got no point this frame and updates which are confirmed
+    //fieldOfView is the half angle in degrees, range the farthest trusted z in mm
+    void endFrame(double fieldOfView, double range);
+
+    //Centers of the confirmed cells in view, in the rover frame
+    void confirmed(double fieldOfView, double range, std::vector<MapPoint> &points) const;
+
+    //Forgets every obstacle
+    void clear();
+
+private:
+    struct Cell {
+        int32_t x, y; //ground coordinates in cells, tells a cell apart from others sharing its slot
+        float evidence;
+        uint32_t hitFrame;
+        bool confirmed;
+    };
+
+    Cell &slot(int32_t x, int32_t y);
+
+    //Rover frame position of a cell's center
+    MapPoint toRover(const Cell &cell) const;
+
+    //True if a rover frame point is in front of the rover and inside the field of view
+    static bool inView(const MapPoint &point, double tanFieldOfView, double range);
+
+    std::vector<Cell> cells;
+    RoverPose pose;
+    double sinHeading;
+    double cosHeading;
+    uint32_t frame;
+};
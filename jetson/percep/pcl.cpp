@@ -11,68 +11,123 @@
         PT_CLOUD_WIDTH{mRoverConfig["pt_cloud"]["pt_cloud_width"].GetInt()},
         PT_CLOUD_HEIGHT{mRoverConfig["pt_cloud"]["pt_cloud_height"].GetInt()},
         HALF_ROVER{mRoverConfig["pt_cloud"]["half_rover"].GetInt()},
-        UP_BD_Z{mRoverConfig["pt_cloud"]["pass_through"]["upper_bd_z"].GetDouble()},
-        UP_BD_Y{mRoverConfig["pt_cloud"]["pass_through"]["upper_bd_y"].GetDouble()},
-        LOW_BD{mRoverConfig["pt_cloud"]["pass_through"]["lower_bd"].GetDouble()},
         ROVER_W_MM{mRoverConfig["pt_cloud"]["rover_w_mm"].GetDouble()},
-        LEAF_SIZE{mRoverConfig["pt_cloud"]["downsample_voxel_filter"].GetFloat()},
-        MAX_ITERATIONS{mRoverConfig["pt_cloud"]["ransac"]["max_iterations"].GetInt()},
-        SEGMENTATION_EPSLION{mRoverConfig["pt_cloud"]["ransac"]["segmentation_epsilon"].GetDouble()},
-        DISTANCE_THRESHOLD{mRoverConfig["pt_cloud"]["ransac"]["distance_threshold"].GetDouble()},
-        CLUSTER_TOLERANCE{mRoverConfig["pt_cloud"]["euclidean_cluster"]["cluster_tolerance"].GetInt()},
-        MIN_CLUSTER_SIZE{mRoverConfig["pt_cloud"]["euclidean_cluster"]["min_cluster_size"].GetInt()},
-        MAX_CLUSTER_SIZE{mRoverConfig["pt_cloud"]["euclidean_cluster"]["max_cluster_size"].GetInt()},
+        HISTOGRAM_ENABLED{!!mRoverConfig["pt_cloud"]["histogram"]["enabled"].GetInt()},
+        HISTOGRAM_SECTORS{mRoverConfig["pt_cloud"]["histogram"]["num_sectors"].GetInt()},
+        SECTOR_WIDTH{2.0 * MAX_FIELD_OF_VIEW_ANGLE / HISTOGRAM_SECTORS},
+        FUSION_ENABLED{!!mRoverConfig["pt_cloud"]["fusion"]["enabled"].GetInt()},
         
         //Other Values
         leftBearing{0}, rightBearing{0}, distance{0}, detected{false},
-        pt_cloud_ptr{new pcl::PointCloud<pcl::PointXYZRGB>} {
+        pt_cloud_ptr{new pcl::PointCloud<pcl::PointXYZRGB>},
+        groundPlaneValid{false}, groundPlaneTracked{false},
+        sectorRanges(HISTOGRAM_SECTORS, -1),
+        stats{{"PassThroughVoxelFilter", "RANSACSegmentation", "ClusterExtraction",
+                "FindInterestPoints", "FuseObstacles", "FindClearPath", "BuildObstacleHistogram", "Total"},
+              (size_t)mRoverConfig["stats"]["window"].GetInt(),
+              mRoverConfig["stats"]["publish_interval_ms"].GetInt()},
+        obstacleMap{mRoverConfig["pt_cloud"]["fusion"]},
+        pose{0, 0, 0},
+        lastFusionNs{0},
+        groundPlaneInlierRatio{0} {
 
         #if PERCEPTION_DEBUG
         viewer = createRGBVisualizer(); //This is a smart pointer so no need to worry ab deleteing it
         viewer_original = createRGBVisualizer();
         #endif
 
-        #if ZED_SDK_PRESENT
-           sl::Resolution cloud_res = sl::Resolution(PT_CLOUD_WIDTH, PT_CLOUD_HEIGHT);
-           cloudArea = cloud_res.area();
-        #else
-            cloudArea = PT_CLOUD_WIDTH*PT_CLOUD_HEIGHT;
-        #endif
+        cloudArea = PT_CLOUD_WIDTH*PT_CLOUD_HEIGHT;
+
+        voxelTable.reserve(cloudArea);
+        voxels.reserve(cloudArea);
 
+        applyConfig(ObstacleConfig(mRoverConfig));
     };
 
-/* --- Pass Through Filter --- */
-//Filters out all points on a given axis passed as a string ("x", "y", or "z") that aren't within the threshold
-//The threshold covers points from 0.0 to upperLimit
+/* --- Apply Config --- */
+//Called between frames, so a frame never sees a mix of old and new parameters
+void PCL::applyConfig(const ObstacleConfig &config) {
+    UP_BD_Z = config.UP_BD_Z;
+    UP_BD_Y = config.UP_BD_Y;
+    LOW_BD = config.LOW_BD;
+    LEAF_SIZE = config.LEAF_SIZE;
+    MAX_ITERATIONS = config.MAX_ITERATIONS;
+    SEGMENTATION_EPSLION = config.SEGMENTATION_EPSLION;
+    DISTANCE_THRESHOLD = config.DISTANCE_THRESHOLD;
+    TRACK_INLIER_RATIO = config.TRACK_INLIER_RATIO;
+    CLUSTER_TOLERANCE = config.CLUSTER_TOLERANCE;
+    MIN_CLUSTER_SIZE = config.MIN_CLUSTER_SIZE;
+    MAX_CLUSTER_SIZE = config.MAX_CLUSTER_SIZE;
+    GRID_CLUSTERING = config.GRID_CLUSTERING;
+
+    //The tracked plane was accepted under the old thresholds
+    groundPlaneValid = false;
+}
+
+/* --- Pass Through Voxel Filter --- */
+//Replaces a z pass through, a y pass through and a voxel grid with one sweep over the raw frame
+//Keeps points with z in [LOW_BD, UP_BD_Z] and y in [LOW_BD, UP_BD_Y]
+//Kept points are binned into voxels of LEAF_SIZE using a hash table
+//Each voxel is then reduced to the centroid (position and color) of its points
 //Values are depth values in mm
-//Source: https://rb.gy/kkyi80
-void PCL::PassThroughFilter(const std::string axis, const double upperLimit) {
+//Sources: https://rb.gy/kkyi80 https://rb.gy/2ybg8n
+void PCL::PassThroughVoxelFilter(const CloudView &input) {
     #if PERCEPTION_DEBUG
-        pcl::ScopeTime t("PassThroughFilter");
+        pcl::ScopeTime t("PassThroughVoxelFilter");
     #endif
 
-    pcl::PassThrough<pcl::PointXYZRGB> pass;
-    pass.setInputCloud(pt_cloud_ptr);
+    const float inverseLeaf = 1.0f / LEAF_SIZE;
+    voxelTable.reserve(input.size);
+    voxelTable.clear();
+    voxels.clear();
 
-    pass.setFilterFieldName(axis);
-    pass.setFilterLimits( LOW_BD, upperLimit);
-    pass.filter(*pt_cloud_ptr);
-}
+    for (size_t n = 0; n < input.size; ++n) {
+        const float x = input.x[n * input.stride];
+        const float y = input.y[n * input.stride];
+        const float z = input.z[n * input.stride];
 
-/* --- Voxel Filter --- */
-//Creates clusters given by the size of a leaf
-//All points in a cluster are then reduced to a single point
-//This point is the centroid of the cluster
-//Source: https://rb.gy/2ybg8n
-void PCL::DownsampleVoxelFilter() {
-    #if PERCEPTION_DEBUG
-        pcl::ScopeTime t("VoxelFilter");
-    #endif
+        //Comparisons with NaN are false, so invalid points are dropped here as well
+        if (!(z >= LOW_BD && z <= UP_BD_Z && y >= LOW_BD && y <= UP_BD_Y) || !std::isfinite(x)) {
+            continue;
+        }
+
+        uint32_t index = voxelTable.insert(VoxelHash::key(VoxelHash::cell(x, inverseLeaf),
+                                                          VoxelHash::cell(y, inverseLeaf),
+                                                          VoxelHash::cell(z, inverseLeaf)));
+        if (index == voxels.size()) {
+            voxels.push_back(VoxelSum{0, 0, 0, 0, 0, 0, 0});
+        }
 
-    pcl::VoxelGrid<pcl::PointXYZRGB> sor;
-    sor.setInputCloud (pt_cloud_ptr);
-    sor.setLeafSize(LEAF_SIZE, LEAF_SIZE, LEAF_SIZE);
-    sor.filter (*pt_cloud_ptr);
+        uint8_t r, g, b;
+        input.color(n, r, g, b);
+
+        VoxelSum &voxel = voxels[index];
+        voxel.x += x;
+        voxel.y += y;
+        voxel.z += z;
+        voxel.r += r;
+        voxel.g += g;
+        voxel.b += b;
+        ++voxel.count;
+    }
+
+    //Only the centroids ever become PCL points
+    std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> &points = pt_cloud_ptr->points;
+    points.resize(voxels.size());
+    for (size_t i = 0; i < voxels.size(); ++i) {
+        const VoxelSum &voxel = voxels[i];
+        float inverseCount = 1.0f / voxel.count;
+        points[i].x = voxel.x * inverseCount;
+        points[i].y = voxel.y * inverseCount;
+        points[i].z = voxel.z * inverseCount;
+        points[i].r = voxel.r / voxel.count;
+        points[i].g = voxel.g / voxel.count;
+        points[i].b = voxel.b / voxel.count;
+        points[i].a = 255;
+    }
+    pt_cloud_ptr->width = points.size();
+    pt_cloud_ptr->height = 1;
+    pt_cloud_ptr->is_dense = true;
 }
 
 /* --- RANSAC Plane Segmentation Blue --- */
@@ -82,30 +137,36 @@ void PCL::DownsampleVoxelFilter() {
 //some threshold then a valid plane has been found
 //Colors all points in this plane blue or
 //removes points completely from point cloud
+//RANSAC only runs when last frame's plane no longer fits, see TrackGroundPlane
 //Source: https://rb.gy/zx6ojh
 void PCL::RANSACSegmentation(string type) {
     #if PERCEPTION_DEBUG
         pcl::ScopeTime t("RANSACSegmentation");
     #endif
 
-    //Creates instance of RANSAC Algorithm
-    pcl::SACSegmentation<pcl::PointXYZRGB> seg;
-    seg.setOptimizeCoefficients(true);
-    seg.setModelType(pcl::SACMODEL_PERPENDICULAR_PLANE);
-    seg.setMethodType(pcl::SAC_RANSAC);
-    seg.setMaxIterations(MAX_ITERATIONS);
-    seg.setDistanceThreshold(DISTANCE_THRESHOLD); //Distance in mm away from actual plane a point can be
-    // to be considered an inlier
-    seg.setAxis(Eigen::Vector3f(0, 1, 0)); //Looks for a plane along the Z axis
-    //Max degree the normal of plane can be from Z axis
-    seg.setEpsAngle(pcl::deg2rad(SEGMENTATION_EPSLION));
-
-    //Objects where segmented plane is stored
-    pcl::ModelCoefficients::Ptr coefficients(new pcl::ModelCoefficients());
     pcl::PointIndices::Ptr inliers(new pcl::PointIndices());
 
-    seg.setInputCloud(pt_cloud_ptr);
-    seg.segment(*inliers, *coefficients);
+    groundPlaneTracked = TrackGroundPlane(*inliers);
+    if(!groundPlaneTracked) {
+        //Creates instance of RANSAC Algorithm
+        pcl::SACSegmentation<pcl::PointXYZRGB> seg;
+        seg.setOptimizeCoefficients(true);
+        seg.setModelType(pcl::SACMODEL_PERPENDICULAR_PLANE);
+        seg.setMethodType(pcl::SAC_RANSAC);
+        seg.setMaxIterations(MAX_ITERATIONS);
+        seg.setDistanceThreshold(DISTANCE_THRESHOLD); //Distance in mm away from actual plane a point can be
+        // to be considered an inlier
+        seg.setAxis(Eigen::Vector3f(0, 1, 0)); //Looks for a plane along the Z axis
+        //Max degree the normal of plane can be from Z axis
+        seg.setEpsAngle(pcl::deg2rad(SEGMENTATION_EPSLION));
+
+        seg.setInputCloud(pt_cloud_ptr);
+        seg.segment(*inliers, groundPlane);
+
+        //Remember how well the new plane fit so later frames have something to compare against
+        groundPlaneValid = !inliers->indices.empty() && groundPlane.values.size() == 4;
+        groundPlaneInlierRatio = pt_cloud_ptr->empty() ? 0 : (double)inliers->indices.size() / pt_cloud_ptr->size();
+    }
 
     if(type == "blue") {
         for (int i = 0; i < (int)inliers->indices.size(); i++) {
@@ -124,28 +185,52 @@ void PCL::RANSACSegmentation(string type) {
     }
 }
 
-/* --- Euclidian Cluster Extraction --- */
-//Creates a KdTree structure from point cloud
-//Use this tree to traverse point cloud and create vector of clusters
-//Return vector of clusters
-//Source: https://rb.gy/qvjati
-void PCL::CPUEuclidianClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices) {
-    #if PERCEPTION_DEBUG
-        pcl::ScopeTime t("CPU Cluster Extraction");
-    #endif
+/* --- Track Ground Plane --- */
+//The ground barely moves between frames while driving, so the plane from
+//the last frame is usually still a good fit
+//Counts the points within DISTANCE_THRESHOLD of that plane in one pass
+//If the fraction of inliers stays above TRACK_INLIER_RATIO of what RANSAC
+//originally found, the plane is refit to those inliers with least squares and kept
+//Otherwise the caller falls back to a full RANSAC search
+bool PCL::TrackGroundPlane(pcl::PointIndices &inliers) {
+    if(!groundPlaneValid || pt_cloud_ptr->empty()) {
+        return false;
+    }
 
-    // Creating the KdTree object for the search method of the extraction
-    pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZRGB>);
-    tree->setInputCloud(pt_cloud_ptr);
+    pcl::SampleConsensusModelPlane<pcl::PointXYZRGB> model(pt_cloud_ptr);
+    Eigen::VectorXf coefficients(4);
+    coefficients << groundPlane.values[0], groundPlane.values[1], groundPlane.values[2], groundPlane.values[3];
 
-    //Extracts clusters using nearet neighbors search
-    pcl::EuclideanClusterExtraction<pcl::PointXYZRGB> ec;
-    ec.setClusterTolerance (CLUSTER_TOLERANCE); // 60 mm radius per point
-    ec.setMinClusterSize (MIN_CLUSTER_SIZE);
-    ec.setMaxClusterSize (MAX_CLUSTER_SIZE);
-    ec.setSearchMethod (tree);
-    ec.setInputCloud (pt_cloud_ptr);
-    ec.extract (cluster_indices);
+    model.selectWithinDistance(coefficients, DISTANCE_THRESHOLD, inliers.indices);
+    double inlierRatio = (double)inliers.indices.size() / pt_cloud_ptr->size();
+    if(inliers.indices.size() < 3 || inlierRatio < TRACK_INLIER_RATIO * groundPlaneInlierRatio) {
+        inliers.indices.clear();
+        return false;
+    }
+
+    //Follow slow changes in the terrain, but never past the angle RANSAC is allowed
+    Eigen::VectorXf refined;
+    model.optimizeModelCoefficients(inliers.indices, coefficients, refined);
+    double angle = std::acos(std::min(1.0f, std::abs(refined[1]) / refined.head<3>().norm()));
+    if(angle > pcl::deg2rad(SEGMENTATION_EPSLION)) {
+        inliers.indices.clear();
+        return false;
+    }
+
+    groundPlane.values.assign(refined.data(), refined.data() + 4);
+    return true;
+}
+
+/* --- Cluster Extraction --- */
+//Runs the clustering method selected by euclidean_cluster/method in the config
+//Both methods return clusters the same way, so later stages don't care which ran
+void PCL::ClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices) {
+    if(GRID_CLUSTERING) {
+        GridClusterExtraction(cluster_indices);
+    }
+    else {
+        CPUEuclidianClusterExtraction(cluster_indices);
+    }
 
     //Colors all clusters
     #if PERCEPTION_DEBUG
@@ -175,11 +260,127 @@ void PCL::CPUEuclidianClusterExtraction(std::vector<pcl::PointIndices> &cluster_
     #endif
 }
 
+/* --- Euclidian Cluster Extraction --- */
+//Creates a KdTree structure from point cloud
+//Use this tree to traverse point cloud and create vector of clusters
+//Return vector of clusters
+//Source: https://rb.gy/qvjati
+void PCL::CPUEuclidianClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices) {
+    #if PERCEPTION_DEBUG
+        pcl::ScopeTime t("CPU Cluster Extraction");
+    #endif
+
+    // Creating the KdTree object for the search method of the extraction
+    pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZRGB>);
+    tree->setInputCloud(pt_cloud_ptr);
+
+    //Extracts clusters using nearet neighbors search
+    pcl::EuclideanClusterExtraction<pcl::PointXYZRGB> ec;
+    ec.setClusterTolerance (CLUSTER_TOLERANCE); // 60 mm radius per point
+    ec.setMinClusterSize (MIN_CLUSTER_SIZE);
+    ec.setMaxClusterSize (MAX_CLUSTER_SIZE);
+    ec.setSearchMethod (tree);
+    ec.setInputCloud (pt_cloud_ptr);
+    ec.extract (cluster_indices);
+}
+
+/* --- Grid Cluster Extraction --- */
+//Bins points into cubic cells CLUSTER_TOLERANCE wide
+//Occupied cells that touch (including diagonally) are joined with union-find
+//Every point in a connected group of cells forms one cluster
+//This is linear in the number of points, unlike building and searching a KdTree,
+//at the cost of treating points up to two cells apart as neighbors
+void PCL::GridClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices) {
+    #if PERCEPTION_DEBUG
+        pcl::ScopeTime t("Grid Cluster Extraction");
+    #endif
+
+    const std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> &points = pt_cloud_ptr->points;
+    const float inverseCell = 1.0f / CLUSTER_TOLERANCE;
+
+    //Assign every point to a cell
+    cellTable.reserve(points.size());
+    cellTable.clear();
+    cells.clear();
+    pointCells.resize(points.size());
+    for(size_t i = 0; i < points.size(); ++i) {
+        GridCell cell{VoxelHash::cell(points[i].x, inverseCell),
+                      VoxelHash::cell(points[i].y, inverseCell),
+                      VoxelHash::cell(points[i].z, inverseCell)};
+        pointCells[i] = cellTable.insert(VoxelHash::key(cell.x, cell.y, cell.z));
+        if(pointCells[i] == cells.size()) {
+            cells.push_back(cell);
+        }
+    }
+
+    //Find the root of a cell, halving the path on the way up
+    auto findRoot = [this](uint32_t c) {
+        while(cellParents[c] != c) {
+            cellParents[c] = cellParents[cellParents[c]];
+            c = cellParents[c];
+        }
+        return c;
+    };
+
+    //Join each cell with its occupied neighbors
+    //Only the 13 neighbors "after" a cell are checked, the other 13 check it
+    cellParents.resize(cells.size());
+    for(uint32_t c = 0; c < cells.size(); ++c) {
+        cellParents[c] = c;
+    }
+    for(uint32_t c = 0; c < cells.size(); ++c) {
+        for(int dx = 0; dx <= 1; ++dx) {
+            for(int dy = (dx ? -1 : 0); dy <= 1; ++dy) {
+                for(int dz = (dx || dy ? -1 : 1); dz <= 1; ++dz) {
+                    int64_t neighbor = cellTable.find(VoxelHash::key(cells[c].x + dx, cells[c].y + dy, cells[c].z + dz));
+                    if(neighbor < 0) continue;
+
+                    uint32_t a = findRoot(c);
+                    uint32_t b = findRoot(neighbor);
+                    if(a != b) {
+                        cellParents[std::max(a, b)] = std::min(a, b);
+                    }
+                }
+            }
+        }
+    }
+
+    //Count the points under each root so undersized and oversized clusters can be skipped
+    rootClusters.assign(cells.size(), 0);
+    for(size_t i = 0; i < points.size(); ++i) {
+        pointCells[i] = findRoot(pointCells[i]);
+        ++rootClusters[pointCells[i]];
+    }
+    for(size_t c = 0; c < cells.size(); ++c) {
+        if(rootClusters[c] >= MIN_CLUSTER_SIZE && rootClusters[c] <= MAX_CLUSTER_SIZE) {
+            cluster_indices.emplace_back();
+            cluster_indices.back().indices.reserve(rootClusters[c]);
+            rootClusters[c] = cluster_indices.size() - 1;
+        }
+        else {
+            rootClusters[c] = -1;
+        }
+    }
+
+    for(size_t i = 0; i < points.size(); ++i) {
+        int cluster = rootClusters[pointCells[i]];
+        if(cluster >= 0) {
+            cluster_indices[cluster].indices.push_back(i);
+        }
+    }
+
+    //Largest first, same as pcl::EuclideanClusterExtraction
+    std::sort(cluster_indices.begin(), cluster_indices.end(), [](const pcl::PointIndices &a, const pcl::PointIndices &b) {
+        return a.indices.size() > b.indices.size();
+    });
+}
+
 /* --- Find Interest Points --- */
 //Finds the edges of each cluster by comparing x and y
 //values of all points in the cluster to find desired ones
 //Interest points are a collection of points that allow us
 //to define the edges of an obsacle
+//Clusters are independent, so they are split across threads
 void PCL::FindInterestPoints(std::vector<pcl::PointIndices> &cluster_indices,
                              std::vector<std::vector<int>> &interest_points) {
 
@@ -187,77 +388,81 @@ void PCL::FindInterestPoints(std::vector<pcl::PointIndices> &cluster_indices,
         pcl::ScopeTime t("Find Interest Points");
     #endif
 
+    const std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> &points = pt_cloud_ptr->points;
+
+    //Cluster sizes vary a lot, so threads take the next cluster when they finish one
+    //OpenMP is optional, without it the loop runs serially
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+    #endif
     for (int i = 0; i < (int)cluster_indices.size(); ++i)
     {
-        std::vector<int>* curr_cluster = &interest_points[i];
+        std::vector<int> &curr_cluster = interest_points[i];
+        const std::vector<int> &indices = cluster_indices[i].indices;
         
         //Initialize interest points
-        std::fill(curr_cluster->begin(), curr_cluster->end(), cluster_indices[i].indices[0]);
+        std::fill(curr_cluster.begin(), curr_cluster.end(), indices[0]);
 
         //Interest Points: 0=Leftmost Point 1=Rightmost Point 2=Lowest Point 3=Highest Point 4=Closest Point 5=Furthest Point.
-        for (auto index : cluster_indices[i].indices)
+        for (int index : indices)
         {
-            auto curr_point = pt_cloud_ptr->points[index];
+            const pcl::PointXYZRGB &curr_point = points[index];
             
-            if(curr_point.x < pt_cloud_ptr->points[curr_cluster->at(0)].x){
-                curr_cluster->at(0) = index;
+            if(curr_point.x < points[curr_cluster[0]].x){
+                curr_cluster[0] = index;
             }
-            if(curr_point.x > pt_cloud_ptr->points[curr_cluster->at(1)].x){
-                curr_cluster->at(1) = index;
+            if(curr_point.x > points[curr_cluster[1]].x){
+                curr_cluster[1] = index;
             }
-            if(curr_point.y < pt_cloud_ptr->points[curr_cluster->at(2)].y){
-                curr_cluster->at(2) = index;
+            if(curr_point.y < points[curr_cluster[2]].y){
+                curr_cluster[2] = index;
             }
-            if(curr_point.y > pt_cloud_ptr->points[curr_cluster->at(3)].y){
-                curr_cluster->at(3) = index;
+            if(curr_point.y > points[curr_cluster[3]].y){
+                curr_cluster[3] = index;
             }
-            if(curr_point.z < pt_cloud_ptr->points[curr_cluster->at(4)].z){
-                curr_cluster->at(4) = index;
+            if(curr_point.z < points[curr_cluster[4]].z){
+                curr_cluster[4] = index;
             }
-            if(curr_point.z > pt_cloud_ptr->points[curr_cluster->at(5)].z){
-                curr_cluster->at(5) = index;
+            if(curr_point.z > points[curr_cluster[5]].z){
+                curr_cluster[5] = index;
             }
         }
 
         //Calulates the width of the obstacle based on the difference between the leftmost and rightmost interest point.
-        double width = std::abs(pt_cloud_ptr->points[curr_cluster->at(1)].x - pt_cloud_ptr->points[curr_cluster->at(0)].x);
+        const float leftmost = points[curr_cluster[0]].x;
+        const float rightmost = points[curr_cluster[1]].x;
+        double width = std::abs(rightmost - leftmost);
         //Calculates the number of rover widths that fit within the obstacle. The x10 multiplier adds more width increments.
         int roverWidths = ((int) width/ROVER_W_MM) * 10;
 
         //Only want to add interest points if the obstacle's width > rover's Width.
         if(roverWidths > 0) {
-            //Create a map data structure where the Key is an int from 0  to roverWidths-1.
-            //Each key index represents the a percentile increment.
+            //Each increment represents a percentile of the obstacle's width.
             //Example: if roverWidths = 40, then index 0 would represent leftmost + 0.025 * obstacle width,
             //index 1 would represent leftmost + 0.05 * obstacle width and so on.
-            std::map<int, double> increments;
-            for(size_t i = 0; i < (size_t) roverWidths; ++i) {
-                //The defualt value stored in each key is the value of the leftmost interest point.
-                increments[i] = pt_cloud_ptr->points[curr_cluster->at(0)].x;
-                //Creates a new interest point and sets it equal to the index of the leftmost point.
-                curr_cluster->push_back(curr_cluster->at(0));
-            }
+            //Every increment starts out as the leftmost interest point.
+            std::vector<float> increments(roverWidths, leftmost);
+            int leftmostIndex = curr_cluster[0];
+            curr_cluster.resize(6 + roverWidths, leftmostIndex);
             
             //Using the x value of the current point, calculate the percentile that the current point would fall under, 
             //and then compare that x value to the one of the point that is currently representing that percentile.
-            for (auto index : cluster_indices[i].indices) {
-                auto curr_point = pt_cloud_ptr->points[index];
-                if(curr_point.x > pt_cloud_ptr->points[curr_cluster->at(0)].x && curr_point.x < pt_cloud_ptr->points[curr_cluster->at(1)].x) {
-                    //If roverWidths = 40 and if your x value falls between leftmost + 0.025 * obstacle width and leftmost + 0.05 * obstacle width,
-                    //then the value of i would be 1 which represents the index of increment map the we want to check.
-                    int j = ((double)(std::abs(curr_point.x - pt_cloud_ptr->points[curr_cluster->at(0)].x)/width)/((double) 1/roverWidths));
+            for (int index : indices) {
+                const float x = points[index].x;
+                if(x > leftmost && x < rightmost) {
+                    int j = std::min(roverWidths - 1, (int)((x - leftmost) / width * roverWidths));
                     //If the x value of the current point is greater than the value representing that percentile, 
                     //we set the value represnting the percentile equal to the x value of the current point.
-                    if(increments[j] < curr_point.x) {
-                        increments[j] = curr_point.x;
-                        curr_cluster->at(6 + j) = index;
+                    if(increments[j] < x) {
+                        increments[j] = x;
+                        curr_cluster[6 + j] = index;
                     }
                 }
             }
         }
         
         #if PERCEPTION_DEBUG
-            for(auto interest_point : *curr_cluster)
+            for(auto interest_point : curr_cluster)
             {
                 pt_cloud_ptr->points[interest_point].r = 255;
                 pt_cloud_ptr->points[interest_point].g = 255;
@@ -267,192 +472,212 @@ void PCL::FindInterestPoints(std::vector<pcl::PointIndices> &cluster_indices,
     }
 }
 
-/* --- Get Angle Off Center--- */
-//This function finds the angle off center the
-//line that passes through both these points is
-//Direction of 0 is left and 1 is right
-double PCL::getAngleOffCenter(int buffer, int direction, const std::vector<std::vector<int>> &interest_points,
-                              std::vector<int> &obstacles) {
-    double newAngle = 0;
-    //If Center Path is blocked check the left or right path depending on direction parameter
-    while (newAngle > -MAX_FIELD_OF_VIEW_ANGLE && newAngle < MAX_FIELD_OF_VIEW_ANGLE) {
-
-        //Finding angle off center
-        double oppSideRTri = pt_cloud_ptr->points[obstacles.at(direction)].x;
-        double adjSideRTri = pt_cloud_ptr->points[obstacles.at(0)].z;            //Length of adjacent side of right triangle
-        oppSideRTri += direction ? buffer + HALF_ROVER : -(buffer + HALF_ROVER); //Calculate length of opposite side of right triangle
-        newAngle = atan(oppSideRTri / adjSideRTri) * 180 / PI;                   //arctan(opposite/adjacent)
-
-        //Create compareLine Functors
-        compareLine leftLine(newAngle, -HALF_ROVER);
-        compareLine rightLine(newAngle, HALF_ROVER);
-
-        obstacles.clear();
-
-        if(CheckPath(interest_points, obstacles, leftLine, rightLine)) {
-            #if PERCEPTION_DEBUG
-                std::cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!FOUND NEW PATH AT: " << newAngle << std::endl;
-            #endif
-            return newAngle;
+/* --- Find Clear Path --- */
+// Calculates left and right bearings
+//The rover's path at a bearing covers a point when |x - z * tan(bearing)| <= HALF_ROVER,
+//so every interest point blocks one continuous range of tan(bearing)
+//Merging those ranges gives every blocked bearing at once, and the clear paths
+//closest to center are the two edges of the merged range that contains straight ahead
+//This replaces re-checking every cluster for each candidate angle
+void PCL::FindClearPath(const std::vector<std::vector<int>> &interest_points) {
+    //Flatten interest points into a compact array so the cloud isn't revisited
+    pathPoints.clear();
+    for(int c = 0; c < (int)interest_points.size(); ++c) {
+        for(int index : interest_points[c]) {
+            const pcl::PointXYZRGB &point = pt_cloud_ptr->points[index];
+            pathPoints.push_back(PathPoint{point.x, point.z, c, index});
         }
     }
-    return direction ? MAX_FIELD_OF_VIEW_ANGLE : -MAX_FIELD_OF_VIEW_ANGLE; //If couldn't find clear path
+    FindClearPath(interest_points.size());
 }
 
-/* --- Find Clear Path --- */
-// Calculates left and right bearings
-void PCL::FindClearPath(const std::vector<std::vector<int>> &interest_points) {
+void PCL::FindClearPath(size_t numClusters) {
     #if PERCEPTION_DEBUG
         pcl::ScopeTime t("Find Clear Path");
     #endif
 
-    std::vector<int> obstacles; //index of the leftmost and rightmost obstacles in path
+    //Clearance in mm kept between the edge of the path and an obstacle
+    const double buffer = 10;
+
+    //Distance to an obstacle is the average z of its points in the center path
+    clusterDistances.assign(numClusters, 0);
+    clusterHits.assign(numClusters, 0);
+    blockedRanges.resize(pathPoints.size());
+    bool centerClear = true;
+    for(size_t i = 0; i < pathPoints.size(); ++i) {
+        const PathPoint &point = pathPoints[i];
+        if(std::abs(point.x) <= HALF_ROVER) {
+            centerClear = false;
+            clusterDistances[point.cluster] += point.z;
+            ++clusterHits[point.cluster];
+
+            #if PERCEPTION_DEBUG
+                //Make interest points orange if they are within rover path
+                if(point.index >= 0) {
+                    pt_cloud_ptr->points[point.index].r = 255;
+                    pt_cloud_ptr->points[point.index].g = 69;
+                    pt_cloud_ptr->points[point.index].b = 0;
+                }
+            #endif
+        }
+
+        //Points at the camera's plane block every bearing their x overlaps
+        double z = std::max(point.z, 1.0f);
+        blockedRanges[i] = BlockedRange{(point.x - HALF_ROVER - buffer) / z, (point.x + HALF_ROVER + buffer) / z};
+    }
+
+    //if there are no obstacles in the center path, the distance should be -1
+    distance = -1;
+    for(size_t c = 0; c < clusterHits.size(); ++c) {
+        if(clusterHits[c] == 0) continue;
+        double clusterDistance = clusterDistances[c] / clusterHits[c];
+        if(distance == -1 || clusterDistance < distance) {
+            distance = clusterDistance;
+        }
+    }
 
     //Check Center Path
-    if(CheckPath(interest_points, obstacles, compareLine(0,-HALF_ROVER), compareLine(0,HALF_ROVER))) {
-      leftBearing = 0; // When no obstacles detected, reset bearings
-      rightBearing = 0;
-      #if PERCEPTION_DEBUG
+    if(centerClear) {
+        leftBearing = 0; // When no obstacles detected, reset bearings
+        rightBearing = 0;
+        #if PERCEPTION_DEBUG
             std::cout << "CENTER PATH IS CLEAR!!!" << std::endl;
-      #endif
+            DrawPath(0, true, "center");
+        #endif
+        return;
     }
-    
-    else {
-
-        //Values that store the distances of the last obstacle from a given CheckPath. Center value gets its distance from previous loop of CheckPath
-        double centerDistance = distance, leftDistance, rightDistance;
 
-        //Initialize base cases outside of scope
-        vector<int> centerObstacles = {obstacles.at(0), obstacles.at(1)};
+    //Merge overlapping ranges until the one containing straight ahead (tan = 0) is complete
+    std::sort(blockedRanges.begin(), blockedRanges.end(), [](const BlockedRange &a, const BlockedRange &b) {
+        return a.lo < b.lo;
+    });
+    BlockedRange center{0, 0};
+    bool open = false;
+    for(const BlockedRange &range : blockedRanges) {
+        if(open && range.lo > center.hi) {
+            if(center.lo <= 0 && center.hi >= 0) break;
+            open = false;
+        }
+        if(!open) {
+            center = range;
+            open = true;
+        }
+        else {
+            center.hi = std::max(center.hi, range.hi);
+        }
+    }
 
-        //Find clear left path, set left bearing
-        leftBearing = getAngleOffCenter(10, 0, interest_points, obstacles);
-        leftDistance = distance; 
+    //If the edge is outside the field of view there is no clear path on that side
+    leftBearing = std::max(atan(center.lo) * 180 / PI, (double)-MAX_FIELD_OF_VIEW_ANGLE);
+    rightBearing = std::min(atan(center.hi) * 180 / PI, (double)MAX_FIELD_OF_VIEW_ANGLE);
+    distance /= 1000.0;
 
-        //Reset global variables
-        obstacles = {0, 0};
-        obstacles.at(0) = centerObstacles.at(0);
-        obstacles.at(1) = centerObstacles.at(1);
+    #if PERCEPTION_DEBUG
+        std::cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!FOUND NEW PATHS AT: " << leftBearing << " " << rightBearing << std::endl;
+        DrawPath(0, false, "center");
+        DrawPath(leftBearing, true, "left");
+        DrawPath(rightBearing, true, "right");
+    #endif
+}
 
-        //Find clear right path, set right bearing
-        rightBearing = getAngleOffCenter(10, 1, interest_points, obstacles);
-        rightDistance = distance;
+/* --- Fuse Obstacles --- */
+//Adds this frame's clustered points to the obstacle map at the rover's current pose
+//and replaces pathPoints with the cells confirmed so far, each its own cluster
+//A real obstacle keeps landing in the same cells as the rover moves while noise
+//rarely hits a cell twice, so only evidence that persists reaches the clear path search
+//Decay follows capture times rather than processing times, so a slow frame
+//doesn't age the map more than the scene did and a replayed bundle decays like the recorded run
+void PCL::FuseObstacles(const std::vector<pcl::PointIndices> &cluster_indices, int64_t sceneNs) {
+    double dt = lastFusionNs == 0 ? 0 : (sceneNs - lastFusionNs) / 1e9;
+    lastFusionNs = sceneNs;
+
+    obstacleMap.beginFrame(pose, dt);
+    for(const pcl::PointIndices &cluster : cluster_indices) {
+        for(int index : cluster.indices) {
+            const pcl::PointXYZRGB &point = pt_cloud_ptr->points[index];
+            obstacleMap.addPoint(point.x, point.z);
+        }
+    }
+    obstacleMap.endFrame(MAX_FIELD_OF_VIEW_ANGLE, UP_BD_Z);
 
-        //return smallest distance of an obstacle from all the paths
-        if(rightDistance < leftDistance && rightDistance < centerDistance) distance = rightDistance/1000.0;
-        else if(leftDistance < rightDistance && leftDistance < centerDistance) distance = leftDistance/1000.0;
-        else distance = centerDistance/1000.0;
+    obstacleMap.confirmed(MAX_FIELD_OF_VIEW_ANGLE, UP_BD_Z, mapPoints);
+    pathPoints.clear();
+    for(const MapPoint &point : mapPoints) {
+        pathPoints.push_back(PathPoint{point.x, point.z, (int)pathPoints.size(), -1});
     }
 }
 
-/* --- Check Path --- */
-//Returns T or F based on whether or not the input path is obstructed
-//If it is obstructed returns false
-//The path is constructed using the left x value and right x value of
-//the furthest points on the path
-bool PCL::CheckPath(const std::vector<std::vector<int>> &interest_points,
-                    std::vector<int> &obstacles, compareLine leftLine, compareLine rightLine) {
+/* --- Build Obstacle Histogram --- */
+//Splits the field of view into HISTOGRAM_SECTORS bearing sectors and keeps
+//the range to the nearest clustered point in each, in a single pass
+//Nav can read off every gap and how far away it closes instead of only
+//the left and right bearings closest to center
+void PCL::BuildObstacleHistogram(const std::vector<pcl::PointIndices> &cluster_indices) {
     #if PERCEPTION_DEBUG
-        pcl::ScopeTime t("Check Path");
+        pcl::ScopeTime t("Build Obstacle Histogram");
     #endif
 
-    bool end = true; 
-    double previousDistance = -1;
-
-    //if there are no interest points, the distance from the last obstacle should be -1
-    distance = previousDistance;
-    
-    //Iterate through interest points
-    for(auto cluster : interest_points) {
-        double sizeOfCluster = 0;
-        double currentDistance = 0;
-        for (auto index : cluster) {
-            //Check if the obstacle interest point is to the right of the left projected path of the rover 
-            //and to the left of the right projected path of the rover
-            if(leftLine(pt_cloud_ptr->points[index].x, pt_cloud_ptr->points[index].z) >= 0 &&
-                rightLine(pt_cloud_ptr->points[index].x, pt_cloud_ptr->points[index].z) <= 0) {
-                end = false;
-
-                //Check if obstacles is initialized
-                if(obstacles.size() == 0) {
-                    obstacles.push_back(index);
-                    obstacles.push_back(index);
-                }
-                //Check if leftmost interest point in rover path
-                else if(pt_cloud_ptr->points[index].x < pt_cloud_ptr->points[obstacles.at(0)].x) {
-                    obstacles.at(0) = index;
-                }
-                //Check if rightmost interest point in rover path
-                else if(pt_cloud_ptr->points[index].x > pt_cloud_ptr->points[obstacles.at(1)].x) {
-                    obstacles.at(1) = index;
-                }
+    std::fill(sectorRanges.begin(), sectorRanges.end(), -1);
+    const double sectorsPerDegree = 1.0 / SECTOR_WIDTH;
 
-                #if PERCEPTION_DEBUG
-                    //Make interest points orange if they are within rover path
-                    pt_cloud_ptr->points[index].r = 255;
-                    pt_cloud_ptr->points[index].g = 69;
-                    pt_cloud_ptr->points[index].b = 0;
-                #endif
+    for(const pcl::PointIndices &cluster : cluster_indices) {
+        for(int index : cluster.indices) {
+            const pcl::PointXYZRGB &point = pt_cloud_ptr->points[index];
+            double bearing = atan2(point.x, point.z) * 180 / PI;
+            int sector = (int)std::floor((bearing + MAX_FIELD_OF_VIEW_ANGLE) * sectorsPerDegree);
+            if(sector < 0 || sector >= HISTOGRAM_SECTORS) continue;
 
-                //adds distance from a point in a cluster to currentDistance, and keeps track of the cluster size
-                currentDistance += pt_cloud_ptr->points[index].z;
-                sizeOfCluster++; 
+            double range = std::sqrt(point.x * point.x + point.z * point.z) / 1000.0;
+            if(sectorRanges[sector] < 0 || range < sectorRanges[sector]) {
+                sectorRanges[sector] = range;
             }
         }
-        //to find the distance from an obstacle detected, add up all the z values from a given cluster of points
-        //then divide by the number of points in the cluster
-        currentDistance = 1.0 * currentDistance / sizeOfCluster;
-
-        //if the last obstacle distance from a CheckPath loop was smaller, keep the smaller value, otherwise keep the current distance value
-        if(currentDistance < previousDistance || (previousDistance == -1 && sizeOfCluster != 0)) {
-            previousDistance = currentDistance;
-            distance = previousDistance;
-        }
     }
+}
 
-    #if PERCEPTION_DEBUG
-        //Project path in viewer
-        pcl::PointXYZRGB pt1;
-        pt1.x = leftLine.xIntercept;
-        pt1.y = 0;
-        pt1.z = 0;
-        pcl::PointXYZRGB pt2;
-        pt2.x = rightLine.xIntercept;
-        pt2.y = 0;
-        pt2.z = 0;
-        pcl::PointXYZRGB pt3(pt1);
-        pt3.z = 7000;
-        pt3.x = leftLine.xIntercept;
-
-        if(leftLine.slope != 0) { //Don't want to divide by 0
-            pt3.x = pt3.z / leftLine.slope + leftLine.xIntercept;
-        }
-
-        pcl::PointXYZRGB pt4(pt2);
-        pt4.z = 7000;
-        pt4.x = rightLine.xIntercept;
+#if PERCEPTION_DEBUG
+/* --- Draw Path --- */
+//Projects the left and right edges of the rover's path 7 m out in the viewer
+void PCL::DrawPath(double angle, bool clear, const std::string &id) {
+    compareLine leftLine(angle, -HALF_ROVER);
+    compareLine rightLine(angle, HALF_ROVER);
+
+    pcl::PointXYZRGB pt1;
+    pt1.x = leftLine.xIntercept;
+    pt1.y = 0;
+    pt1.z = 0;
+    pcl::PointXYZRGB pt2;
+    pt2.x = rightLine.xIntercept;
+    pt2.y = 0;
+    pt2.z = 0;
+    pcl::PointXYZRGB pt3(pt1);
+    pt3.z = 7000;
+    pt3.x = leftLine.xIntercept;
+
+    if(leftLine.slope != 0) { //Don't want to divide by 0
+        pt3.x = pt3.z / leftLine.slope + leftLine.xIntercept;
+    }
 
-        if(rightLine.slope != 0) { //Don't want to divide by 0
-            pt4.x = pt4.z / rightLine.slope + rightLine.xIntercept;
-        }
+    pcl::PointXYZRGB pt4(pt2);
+    pt4.z = 7000;
+    pt4.x = rightLine.xIntercept;
 
-        if(end) {
-            viewer->removeShape("l1");
-            viewer->removeShape("l2");
-            viewer->addLine(pt1, pt3, 0, 255, 0, "l1");
-            viewer->addLine(pt2, pt4, 0, 255, 0, "l2");
-        }
-        else {
-            viewer->removeShape("l1");
-            viewer->removeShape("l2");
-            viewer->addLine(pt1, pt3, 255, 0, 0, "l1");
-            viewer->addLine(pt2, pt4, 255, 0, 0, "l2");
-        }
-    #endif
+    if(rightLine.slope != 0) { //Don't want to divide by 0
+        pt4.x = pt4.z / rightLine.slope + rightLine.xIntercept;
+    }
 
-    return end;
+    viewer->removeShape(id + "l1");
+    viewer->removeShape(id + "l2");
+    if(clear) {
+        viewer->addLine(pt1, pt3, 0, 255, 0, id + "l1");
+        viewer->addLine(pt2, pt4, 0, 255, 0, id + "l2");
+    }
+    else {
+        viewer->addLine(pt1, pt3, 255, 0, 0, id + "l1");
+        viewer->addLine(pt2, pt4, 255, 0, 0, id + "l2");
+    }
 }
-
+#endif
 
 void PCL::updateViewer(bool is_original) {
     if(is_original) {
@@ -487,36 +712,69 @@ shared_ptr<pcl::visualization::PCLVisualizer> PCL::createRGBVisualizer() {
 /* --- Main --- */
 //This is the main point cloud processing function
 //It returns the bearing the rover should traverse
-//For the PassThroughFilter function we can trust the ZED depth for up to 7000 mm (7 m) for "z" axis.
+//For the PassThroughVoxelFilter function we can trust the ZED depth for up to 7000 mm (7 m) for "z" axis.
 //3000 mm (3m) for "x" is a placeholder, we will chnage this value based on further testing.
 //This function is called in main.cpp
-void PCL::pcl_obstacle_detection() {
-    obstacle_return result;
-    PassThroughFilter("z", UP_BD_Z);
-    PassThroughFilter("y", UP_BD_Y);
-    DownsampleVoxelFilter();
+void PCL::pcl_obstacle_detection(const PointBuffer &points, int64_t sceneNs) {
+    StageClock clock(stats);
+    PassThroughVoxelFilter(CloudView(points));
+    clock.lap(FILTER_STAGE);
     RANSACSegmentation("remove");
-    std::vector<pcl::PointIndices> cluster_indices;
-    CPUEuclidianClusterExtraction(cluster_indices);
-    std::vector<std::vector<int>> interest_points(cluster_indices.size(), vector<int> (6));
-    FindInterestPoints(cluster_indices, interest_points);
-    FindClearPath(interest_points); 
+    clock.lap(RANSAC_STAGE);
+    cluster_indices.clear();
+    ClusterExtraction(cluster_indices);
+    clock.lap(CLUSTER_STAGE);
+    if(FUSION_ENABLED) {
+        //Confirmed cells already outline every obstacle, interest points aren't needed
+        FuseObstacles(cluster_indices, sceneNs);
+        clock.lap(FUSION_STAGE);
+        FindClearPath(pathPoints.size());
+    }
+    else {
+        std::vector<std::vector<int>> interest_points(cluster_indices.size(), vector<int> (6));
+        FindInterestPoints(cluster_indices, interest_points);
+        clock.lap(INTEREST_POINTS_STAGE);
+        FindClearPath(interest_points);
+    }
+    clock.lap(CLEAR_PATH_STAGE);
+    if(HISTOGRAM_ENABLED) {
+        BuildObstacleHistogram(cluster_indices);
+        clock.lap(HISTOGRAM_STAGE);
+    }
+    clock.total(OBSTACLE_TOTAL_STAGE);
 }
 
 
 
-/* --- Update --- */
-//Cleares and resizes cloud for new data
-void PCL::update() {
-    pt_cloud_ptr->clear();
-    pt_cloud_ptr->points.resize(cloudArea);
-    pt_cloud_ptr->width = PT_CLOUD_WIDTH;
-    pt_cloud_ptr->height = PT_CLOUD_HEIGHT;
+/* --- Point Buffer Conversions --- */
+//ZED colors are packed as bytes R, G, B, A while PCL packs them as B, G, R, A
+void pointBufferToCloud(const PointBuffer &points, pcl::PointCloud<pcl::PointXYZRGB> &cloud) {
+    CloudView view(points);
+    cloud.points.resize(view.size);
+    cloud.width = points.width;
+    cloud.height = points.height;
+    cloud.is_dense = false;
+    for (size_t n = 0; n < view.size; ++n) {
+        pcl::PointXYZRGB &point = cloud.points[n];
+        point.x = view.x[n * view.stride];
+        point.y = view.y[n * view.stride];
+        point.z = view.z[n * view.stride];
+        view.color(n, point.r, point.g, point.b);
+        point.a = 255;
+    }
+}
 
-    #if PERCEPTION_DEBUG
-        std::cout << "Width: " << pt_cloud_ptr->width << std::endl;
-        std::cout << "Height: " << pt_cloud_ptr->height << "\n";
-    #endif
+void cloudToPointBuffer(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, PointBuffer &points) {
+    points.resize(cloud.width, cloud.height);
+    float *data = points.data.data();
+    for (const pcl::PointXYZRGB &point : cloud.points) {
+        uint32_t packed = (uint32_t)point.r | (uint32_t)point.g << 8 | (uint32_t)point.b << 16 | 0xFF000000u;
+        data[0] = point.x;
+        data[1] = point.y;
+        data[2] = point.z;
+        std::memcpy(&data[3], &packed, sizeof(packed));
+        data += 4;
+    }
 }
 
 #endif
@@ -2,9 +2,27 @@
 #pragma once
 
 #include "perception.hpp"
+#include "stage_stats.hpp"
+#include "point_buffer.hpp"
+#include "voxel_hash.hpp"
+#include "perception_config.hpp"
+#include "obstacle_map.hpp"
 #include <pcl/common/common_headers.h>
 #include <float.h>
 
+//Stages of the obstacle pipeline that are timed every frame
+enum ObstacleStage {
+    FILTER_STAGE,
+    RANSAC_STAGE,
+    CLUSTER_STAGE,
+    INTEREST_POINTS_STAGE,
+    FUSION_STAGE,
+    CLEAR_PATH_STAGE,
+    HISTOGRAM_STAGE,
+    OBSTACLE_TOTAL_STAGE,
+    NUM_OBSTACLE_STAGES
+};
+
 /* --- Compare Line Class --- */
 /**
 \brief Functor that indicates where a point is in
@@ -47,6 +65,30 @@ public:
     }
 };
 
+//Running sums of the points that fell into one voxel
+struct VoxelSum {
+    float x, y, z;
+    uint32_t r, g, b;
+    uint32_t count;
+};
+
+//An interest point reduced to what the clear path search needs
+struct PathPoint {
+    float x, z;
+    int cluster;
+    int index;
+};
+
+//Range of tan(bearing) that a single interest point blocks
+struct BlockedRange {
+    double lo, hi;
+};
+
+//Integer coordinates of an occupied cell in the clustering grid
+struct GridCell {
+    int64_t x, y, z;
+};
+
 class PCL {
     public:
         shared_ptr<pcl::visualization::PCLVisualizer> viewer;
@@ -67,11 +109,21 @@ class PCL {
         int MAX_ITERATIONS;
         double SEGMENTATION_EPSLION;
         double DISTANCE_THRESHOLD;
+        double TRACK_INLIER_RATIO;
 
         //Euclidean cluster constants
         int CLUSTER_TOLERANCE;
         int MIN_CLUSTER_SIZE;
         int MAX_CLUSTER_SIZE;
+        bool GRID_CLUSTERING;
+
+        //Polar histogram constants
+        bool HISTOGRAM_ENABLED;
+        int HISTOGRAM_SECTORS;
+        double SECTOR_WIDTH;
+
+        //Temporal fusion constants, the map reads the rest
+        bool FUSION_ENABLED;
         
         //member variables
         double leftBearing;
@@ -81,9 +133,33 @@ class PCL {
         pcl::PointCloud<pcl::PointXYZRGB>::Ptr pt_cloud_ptr;
         int cloudArea;
 
+        //Ground plane from the last frame, used to seed the next segmentation
+        //groundPlaneTracked is true if the last frame reused it instead of running RANSAC
+        pcl::ModelCoefficients groundPlane;
+        bool groundPlaneValid;
+        bool groundPlaneTracked;
+
+        //Nearest obstacle in meters for each bearing sector, -1 if the sector is clear
+        //Sector 0 starts at -MAX_FIELD_OF_VIEW_ANGLE and each is SECTOR_WIDTH degrees wide
+        std::vector<double> sectorRanges;
+
+        //Points of pt_cloud_ptr in each obstacle found in the last frame
+        std::vector<pcl::PointIndices> cluster_indices;
+
+        //Rolling latency of each ObstacleStage
+        StageStats stats;
+
         //Constructor
         PCL(const rapidjson::Document &mRoverConfig);
 
+        //Replaces the filter, RANSAC and cluster constants with a reloaded config
+        void applyConfig(const ObstacleConfig &config);
+
+        //Pose the next frame is fused at
+        void setPose(const RoverPose &roverPose) {
+            pose = roverPose;
+        }
+
         //Destructor for PCL
         ~PCL() {
         #if OBSTACLE_DETECTION && PERCEPTION_DEBUG 
@@ -94,17 +170,26 @@ class PCL {
 
     private:
 
-        //Filters points with values beyond certain threshold
-        void PassThroughFilter(const std::string axis, const double upperLimit);
-        
-        //Clusters nearby points to reduce total number of points
-        void DownsampleVoxelFilter();
+        //Filters points beyond the z and y thresholds and reduces the
+        //remaining points to one centroid per voxel in a single sweep
+        //The centroids are written to pt_cloud_ptr
+        void PassThroughVoxelFilter(const CloudView &input);
         
         //Finds the ground plane
         void RANSACSegmentation(string type);
+
+        //Checks whether last frame's ground plane still fits the cloud
+        //Returns false if RANSAC has to search for a new plane
+        bool TrackGroundPlane(pcl::PointIndices &inliers);
         
-        //Clusters nearby points into large obstacles
+        //Clusters nearby points into large obstacles with the method chosen in the config
+        void ClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices);
+
+        //Clusters nearby points into large obstacles using a KdTree
         void CPUEuclidianClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices);
+
+        //Clusters nearby points into large obstacles by connecting occupied grid cells
+        void GridClusterExtraction(std::vector<pcl::PointIndices> &cluster_indices);
         
         //Finds the four corners of the clustered obstacles
         void FindInterestPoints(std::vector<pcl::PointIndices> &cluster_indices, std::vector<std::vector<int>> &interest_points);
@@ -112,20 +197,51 @@ class PCL {
         //Finds a clear path given the obstacle corners
         void FindClearPath(const std::vector<std::vector<int>> &interest_points);
 
-        //Determines whether the input path is obstructed
-        bool CheckPath(const std::vector<std::vector<int>> &interest_points,
-               std::vector<int> &obstacles, compareLine leftLine, compareLine rightLine);
-        
-        /**
-        \brief Determines angle off center a clear path can be found
-        \param direction: given 0 finds left clear path given 1 find right clear path
-        */
-        double getAngleOffCenter(int buffer, int direction, const std::vector<std::vector<int>> &interest_points,
-                    std::vector<int> &obstacles);
+        //Finds a clear path around pathPoints, whose clusters are numbered below numClusters
+        void FindClearPath(size_t numClusters);
+
+        //Accumulates the clustered points in obstacleMap and fills pathPoints with the confirmed cells
+        //sceneNs is when the frame was captured, evidence decays by the time between captures
+        void FuseObstacles(const std::vector<pcl::PointIndices> &cluster_indices, int64_t sceneNs);
+
+        //Bins every clustered point into sectorRanges
+        void BuildObstacleHistogram(const std::vector<pcl::PointIndices> &cluster_indices);
+
+        #if PERCEPTION_DEBUG
+        //Projects a path of the rover's width at angle in the viewer, green if clear, red otherwise
+        void DrawPath(double angle, bool clear, const std::string &id);
+        #endif
+
+        //Voxel table and sums reused across frames by PassThroughVoxelFilter
+        VoxelHash voxelTable;
+        std::vector<VoxelSum> voxels;
+
+        //Scratch space reused across frames by GridClusterExtraction
+        VoxelHash cellTable;
+        std::vector<GridCell> cells;
+        std::vector<uint32_t> pointCells;
+        std::vector<uint32_t> cellParents;
+        std::vector<int> rootClusters;
+
+        //Scratch space reused across frames by FindClearPath
+        std::vector<PathPoint> pathPoints;
+        std::vector<BlockedRange> blockedRanges;
+        std::vector<double> clusterDistances;
+        std::vector<int> clusterHits;
+
+        //Obstacle evidence across frames, and where the rover was for this frame
+        ObstacleMap obstacleMap;
+        RoverPose pose;
+        int64_t lastFusionNs; //capture time of the last fused frame, 0 before the first
+        std::vector<MapPoint> mapPoints;
+
+        //Fraction of the cloud that was on the plane when RANSAC last found it
+        double groundPlaneInlierRatio;
 
     public:
-        //Main function that runs the above 
-        void pcl_obstacle_detection();
+        //Main function that runs the above, sceneNs is the system clock when points were
+        //captured, the recording's time on a replay
+        void pcl_obstacle_detection(const PointBuffer &points, int64_t sceneNs);
 
         //Updates point cloud in the visualizer
         //Note: if bool is_original is true, we are using the original viewer
@@ -133,9 +249,11 @@ class PCL {
         
         //Creates a point cloud visualizer
         shared_ptr<pcl::visualization::PCLVisualizer> createRGBVisualizer();
-
-        //Cleares and resizes cloud for new data
-        void update();
 };
 
+//Converts between the raw ZED layout and PCL clouds
+//Used for recording, offline replay and the debug viewer, not on the detection path
+void pointBufferToCloud(const PointBuffer &points, pcl::PointCloud<pcl::PointXYZRGB> &cloud);
+void cloudToPointBuffer(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, PointBuffer &points);
+
 #endif
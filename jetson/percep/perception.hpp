@@ -19,10 +19,8 @@
 
 #if OBSTACLE_DETECTION
 /* --- PCL Includes --- */
-#include <pcl/filters/voxel_grid.h>
 #include <pcl/common/common_headers.h>
 #include <pcl/point_types.h>
-#include <pcl/filters/passthrough.h>
 #include <pcl/common/time.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/filters/extract_indices.h>
@@ -31,6 +29,7 @@
 #include <pcl/kdtree/kdtree.h>
 #include <pcl/sample_consensus/method_types.h>
 #include <pcl/sample_consensus/model_types.h>
+#include <pcl/sample_consensus/sac_model_plane.h>
 #include <pcl/segmentation/extract_clusters.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_types.h>
@@ -0,0 +1,217 @@
+#include "perception_config.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/* --- Obstacle Config --- */
+//Looks up section/name, throws naming the setting if it is missing
+//rapidjson asserts on a missing member, so nothing is read without this
+static const rapidjson::Value &setting(const rapidjson::Value &section, const std::string &path, const char *name) {
+    if (!section.IsObject() || !section.HasMember(name)) {
+        throw std::runtime_error(path + name + " is missing");
+    }
+    return section[name];
+}
+
+static double getDouble(const rapidjson::Value &section, const std::string &path, const char *name) {
+    const rapidjson::Value &value = setting(section, path, name);
+    if (!value.IsNumber()) throw std::runtime_error(path + name + " is not a number");
+    return value.GetDouble();
+}
+
+static int getInt(const rapidjson::Value &section, const std::string &path, const char *name) {
+    const rapidjson::Value &value = setting(section, path, name);
+    if (!value.IsInt()) throw std::runtime_error(path + name + " is not an integer");
+    return value.GetInt();
+}
+
+static std::string getString(const rapidjson::Value &section, const std::string &path, const char *name) {
+    const rapidjson::Value &value = setting(section, path, name);
+    if (!value.IsString()) throw std::runtime_error(path + name + " is not a string");
+    return value.GetString();
+}
+
+ObstacleConfig::ObstacleConfig(const rapidjson::Value &mRoverConfig) {
+    const rapidjson::Value &ptCloud = setting(mRoverConfig, "", "pt_cloud");
+    const rapidjson::Value &passThrough = setting(ptCloud, "pt_cloud/", "pass_through");
+    const rapidjson::Value &ransac = setting(ptCloud, "pt_cloud/", "ransac");
+    const rapidjson::Value &cluster = setting(ptCloud, "pt_cloud/", "euclidean_cluster");
+
+    UP_BD_Z = getDouble(passThrough, "pt_cloud/pass_through/", "upper_bd_z");
+    UP_BD_Y = getDouble(passThrough, "pt_cloud/pass_through/", "upper_bd_y");
+    LOW_BD = getDouble(passThrough, "pt_cloud/pass_through/", "lower_bd");
+    LEAF_SIZE = (float)getDouble(ptCloud, "pt_cloud/", "downsample_voxel_filter");
+    MAX_ITERATIONS = getInt(ransac, "pt_cloud/ransac/", "max_iterations");
+    SEGMENTATION_EPSLION = getDouble(ransac, "pt_cloud/ransac/", "segmentation_epsilon");
+    DISTANCE_THRESHOLD = getDouble(ransac, "pt_cloud/ransac/", "distance_threshold");
+    TRACK_INLIER_RATIO = getDouble(ransac, "pt_cloud/ransac/", "track_inlier_ratio");
+    CLUSTER_TOLERANCE = getInt(cluster, "pt_cloud/euclidean_cluster/", "cluster_tolerance");
+    MIN_CLUSTER_SIZE = getInt(cluster, "pt_cloud/euclidean_cluster/", "min_cluster_size");
+    MAX_CLUSTER_SIZE = getInt(cluster, "pt_cloud/euclidean_cluster/", "max_cluster_size");
+    GRID_CLUSTERING = getString(cluster, "pt_cloud/euclidean_cluster/", "method") == "grid";
+
+    //The filter and grid clustering divide by LEAF_SIZE and CLUSTER_TOLERANCE
+    if (!(LEAF_SIZE > 0)) throw std::runtime_error("pt_cloud/downsample_voxel_filter must be positive");
+    if (!(LOW_BD < UP_BD_Z && LOW_BD < UP_BD_Y)) {
+        throw std::runtime_error("pt_cloud/pass_through/lower_bd must be below both upper bounds");
+    }
+    if (MAX_ITERATIONS <= 0) throw std::runtime_error("pt_cloud/ransac/max_iterations must be positive");
+    if (!(SEGMENTATION_EPSLION >= 0)) throw std::runtime_error("pt_cloud/ransac/segmentation_epsilon can't be negative");
+    if (!(DISTANCE_THRESHOLD > 0)) throw std::runtime_error("pt_cloud/ransac/distance_threshold must be positive");
+    if (!(TRACK_INLIER_RATIO >= 0 && TRACK_INLIER_RATIO <= 1)) {
+        throw std::runtime_error("pt_cloud/ransac/track_inlier_ratio must be between 0 and 1");
+    }
+    if (CLUSTER_TOLERANCE <= 0) throw std::runtime_error("pt_cloud/euclidean_cluster/cluster_tolerance must be positive");
+    if (MIN_CLUSTER_SIZE <= 0 || MIN_CLUSTER_SIZE > MAX_CLUSTER_SIZE) {
+        throw std::runtime_error("pt_cloud/euclidean_cluster/min_cluster_size must be positive and at most max_cluster_size");
+    }
+}
+
+/* --- Tag Config --- */
+//TagDetector is built on the AR thread once capture has started, so the
+//settings it can't recover from are checked here, before any thread starts
+static void checkTagConfig(const rapidjson::Value &mRoverConfig) {
+    const rapidjson::Value &arTag = setting(mRoverConfig, "", "ar_tag");
+    const rapidjson::Value &depth = setting(arTag, "ar_tag/", "depth");
+
+    //Trimming half or more from each end would leave no samples to average
+    double trimFraction = getDouble(depth, "ar_tag/depth/", "trim_fraction");
+    if (!(trimFraction >= 0 && trimFraction < 0.5)) {
+        throw std::runtime_error("ar_tag/depth/trim_fraction must be at least 0 and below 0.5");
+    }
+}
+
+/* --- Perception Config --- */
+//True if every setting in expected is present in actual with a compatible type
+//Any number may replace any number, ObstacleConfig checks the ones it reads
+//against the getter it uses, and the rest of the document is only read at startup
+static bool sameShape(const rapidjson::Value &expected, const rapidjson::Value &actual, std::string &where) {
+    if (expected.IsObject()) {
+        if (!actual.IsObject()) return false;
+        for (auto it = expected.MemberBegin(); it != expected.MemberEnd(); ++it) {
+            std::string name = it->name.GetString();
+            if (!actual.HasMember(name.c_str())) {
+                where = name + " is missing";
+                return false;
+            }
+            if (!sameShape(it->value, actual[name.c_str()], where)) {
+                if (where.empty()) where = name + " changed type";
+                return false;
+            }
+        }
+        return true;
+    }
+    if (expected.IsNumber()) return actual.IsNumber();
+    if (expected.IsString()) return actual.IsString();
+    if (expected.IsBool()) return actual.IsBool();
+    if (expected.IsArray()) return actual.IsArray();
+    return true;
+}
+
+PerceptionConfig::PerceptionConfig(const std::string &json, const PerceptionConfig *reference) {
+    document.Parse(json.c_str());
+    if (document.HasParseError() || !document.IsObject()) {
+        throw std::runtime_error("config is not a valid JSON object (error at offset " +
+                                 std::to_string(document.GetErrorOffset()) + ")");
+    }
+    std::string where;
+    if (reference && !sameShape(reference->document, document, where)) {
+        throw std::runtime_error(where);
+    }
+    obstacle = std::make_shared<const ObstacleConfig>(document);
+    checkTagConfig(document);
+}
+
+/* --- Config Watcher --- */
+
+ConfigWatcher::ConfigWatcher(const std::string &path) : path_{path}, version_{0}, running_{false} {
+    std::ifstream file(path_);
+    if (!file) {
+        throw std::runtime_error("could not open " + path_);
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    startup_ = std::make_shared<const PerceptionConfig>(contents.str());
+    current_ = startup_;
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+std::shared_ptr<const PerceptionConfig> ConfigWatcher::current() const {
+    return std::atomic_load(&current_);
+}
+
+unsigned ConfigWatcher::version() const {
+    return version_.load(std::memory_order_acquire);
+}
+
+void ConfigWatcher::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&ConfigWatcher::watch, this);
+}
+
+void ConfigWatcher::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+std::shared_ptr<const PerceptionConfig> ConfigWatcher::load() {
+    std::ifstream file(path_);
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    std::shared_ptr<const PerceptionConfig> config;
+    try {
+        config = std::make_shared<const PerceptionConfig>(contents.str(), startup_.get());
+    } catch (const std::runtime_error &e) {
+        std::cerr << "Ignoring " << path_ << ": " << e.what() << std::endl;
+    }
+    return config;
+}
+
+void ConfigWatcher::watch() {
+    // Editors usually save by writing a temporary file and renaming it over the
+    // old one, which would orphan a watch on the file itself, so the directory is watched
+    size_t slash = path_.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : path_.substr(0, slash);
+    std::string name = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Could not watch " << path_ << ", config will not reload" << std::endl;
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (running_) {
+        // wake up periodically so stop() never waits long
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 250) <= 0) continue;
+
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char *p = buffer; p < buffer + length;) {
+                auto *event = reinterpret_cast<inotify_event *>(p);
+                changed = changed || (event->len > 0 && name == event->name);
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (!changed) continue;
+
+        std::shared_ptr<const PerceptionConfig> config = load();
+        if (config) {
+            std::atomic_store(&current_, config);
+            version_.fetch_add(1, std::memory_order_release);
+            std::cout << "Reloaded " << path_ << std::endl;
+        }
+    }
+    close(fd);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "rapidjson/document.h"
+
+/* --- Obstacle Config --- */
+//Obstacle detection parameters that may be retuned while perception is running
+//Everything else in the config is read once at startup
+struct ObstacleConfig {
+    //Pass through and voxel filter
+    double UP_BD_Z;
+    double UP_BD_Y;
+    double LOW_BD;
+    float LEAF_SIZE;
+
+    //RANSAC
+    int MAX_ITERATIONS;
+    double SEGMENTATION_EPSLION;
+    double DISTANCE_THRESHOLD;
+    double TRACK_INLIER_RATIO;
+
+    //Euclidean cluster
+    int CLUSTER_TOLERANCE;
+    int MIN_CLUSTER_SIZE;
+    int MAX_CLUSTER_SIZE;
+    bool GRID_CLUSTERING;
+
+    //Throws std::runtime_error naming the setting if one is missing,
+    //of a type its getter can't read, or out of range
+    ObstacleConfig(const rapidjson::Value &mRoverConfig);
+};
+
+/* --- Perception Config --- */
+//One parsed snapshot of config.json, never modified once built
+struct PerceptionConfig {
+    rapidjson::Document document;
+    std::shared_ptr<const ObstacleConfig> obstacle;
+
+    //Throws std::runtime_error if json does not parse, if its obstacle or tag settings
+    //are not valid, or if reference is given and json is missing one of its settings
+    //or changes a setting's type
+    PerceptionConfig(const std::string &json, const PerceptionConfig *reference = nullptr);
+};
+
+/* --- Config Watcher --- */
+//Owns the current PerceptionConfig and replaces it whenever config.json is saved
+//Stages pick up the new snapshot between frames by calling current()
+//A file that does not parse, has an invalid obstacle setting, or is missing a
+//setting or changes its type compared to the startup config, is reported and ignored
+class ConfigWatcher {
+public:
+    //Loads the config once, throws std::runtime_error if it can't be read or parsed
+    ConfigWatcher(const std::string &path);
+
+    ~ConfigWatcher();
+
+    //Snapshot that was current at the time of the call, safe from any thread
+    std::shared_ptr<const PerceptionConfig> current() const;
+
+    //Bumped every time a new snapshot is swapped in, cheap to poll once per frame
+    unsigned version() const;
+
+    //Starts watching the file with inotify on a background thread
+    void start();
+
+    //Stops the watcher thread, called by the destructor
+    void stop();
+
+private:
+    //Reads and parses the file, returns null and prints why if it is not usable
+    std::shared_ptr<const PerceptionConfig> load();
+
+    void watch();
+
+    std::string path_;
+    std::shared_ptr<const PerceptionConfig> startup_;
+    std::shared_ptr<const PerceptionConfig> current_;
+    std::atomic<unsigned> version_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
@@ -0,0 +1,305 @@
+#include "pipeline.hpp"
+
+using namespace std::chrono_literals;
+
+//Stamps a /target_list or /obstacle message with when its frame was captured
+//and how long it took to get from the camera to here, returns that latency
+template <typename Message>
+static double stampMessage(Message &message, const Frame &frame) {
+    int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    message.capture_time_us = frame.captureNs / 1000;
+    message.latency_ms = (nowNs - frame.captureNs) / 1e6;
+    return message.latency_ms;
+}
+
+template <typename Backend>
+Pipeline<Backend>::Pipeline(const rapidjson::Document &mRoverConfig, Camera<Backend> &cam, lcm::LCM &lcm_, ConfigWatcher &config) :
+
+    //Populate Constants from Config File
+    QUEUE_CAPACITY{mRoverConfig["pipeline"]["queue_capacity"].GetInt()},
+    DROP_OLDEST{!!mRoverConfig["pipeline"]["drop_oldest"].GetInt()},
+    PT_CLOUD_WIDTH{mRoverConfig["pt_cloud"]["pt_cloud_width"].GetInt()},
+    PT_CLOUD_HEIGHT{mRoverConfig["pt_cloud"]["pt_cloud_height"].GetInt()},
+    DEFAULT_TAG_VAL{mRoverConfig["ar_tag"]["default_tag_val"].GetInt()},
+    DEBUG_STREAM_SCALE{mRoverConfig["debug_stream"]["scale"].GetDouble()},
+    DEBUG_STREAM_MAX_POINTS{mRoverConfig["debug_stream"]["max_points"].GetInt()},
+    DEBUG_STREAM_RING_SIZE{mRoverConfig["debug_stream"]["ring_size"].GetInt()},
+    DEBUG_STREAM_REFRESH_MS{mRoverConfig["debug_stream"]["refresh_ms"].GetInt()},
+
+    mRoverConfig{mRoverConfig}, cam{cam}, lcm_{lcm_}, config{config},
+    pointPool{PT_CLOUD_WIDTH, PT_CLOUD_HEIGHT, (size_t)(2 * QUEUE_CAPACITY + 2)},
+    arQueue{(size_t)QUEUE_CAPACITY, DROP_OLDEST},
+    obstacleQueue{(size_t)QUEUE_CAPACITY, DROP_OLDEST},
+    tagSnapshots{(size_t)DEBUG_STREAM_RING_SIZE},
+    obstacleSnapshots{(size_t)DEBUG_STREAM_RING_SIZE},
+    listening{true} {}
+
+/* --- Run --- */
+//Detection stages are started first so the queues are drained as soon as capture begins
+//Capture stays on the calling thread since the ZED SDK expects grab and retrieve on one thread
+template <typename Backend>
+void Pipeline<Backend>::run() {
+    std::thread arThread(&Pipeline<Backend>::arStage, this);
+    std::thread obstacleThread(&Pipeline<Backend>::obstacleStage, this);
+    #if OBSTACLE_DETECTION
+        std::thread odometryThread(&Pipeline<Backend>::odometryStage, this);
+    #endif
+
+    #if DEBUG_STREAM
+        //Renders on its own thread so detection never waits on a window
+        DebugViewer viewer(tagSnapshots, obstacleSnapshots, mRoverConfig["pt_cloud"]["pass_through"]["upper_bd_z"].GetDouble(),
+                           mRoverConfig["pt_cloud"]["max_field_of_view_angle"].GetInt(), DEBUG_STREAM_REFRESH_MS);
+        std::thread viewerThread(&DebugViewer::run, &viewer);
+    #endif
+
+    captureStage();
+
+    arThread.join();
+    obstacleThread.join();
+    #if OBSTACLE_DETECTION
+        listening = false;
+        odometryThread.join();
+    #endif
+
+    #if DEBUG_STREAM
+        viewer.stop();
+        viewerThread.join();
+    #endif
+
+    #if PERCEPTION_DEBUG
+        std::cout << "Frames dropped by AR stage: " << arQueue.dropped() << std::endl;
+        std::cout << "Frames dropped by obstacle stage: " << obstacleQueue.dropped() << std::endl;
+    #endif
+}
+
+/* --- Capture Stage --- */
+template <typename Backend>
+void Pipeline<Backend>::captureStage() {
+    int iterations = 0;
+
+    //Check to see if we were able to grab the frame
+    while (cam.grab()) {
+        Frame frame;
+        frame.id = iterations;
+        frame.captureNs = cam.timestamp();
+        frame.sceneNs = cam.sceneTimestamp();
+
+        #if AR_DETECTION
+        //ZED images point into SDK owned buffers that the next grab overwrites
+        frame.src = cam.image().clone();
+        frame.depth = cam.depth().clone();
+        #endif
+
+        #if OBSTACLE_DETECTION
+        //Buffers are recycled through the pool once both stages are done with them
+        frame.points = pointPool.acquire();
+        cam.getDataCloud(*frame.points);
+        #endif
+
+        #if WRITE_CURR_FRAME_TO_DISK && AR_DETECTION && OBSTACLE_DETECTION
+            if (iterations % cam.FRAME_WRITE_INTERVAL == 0) {
+                cam.write_curr_frame_to_disk(frame.src, frame.depth, frame.points, frame.sceneNs, iterations);
+            }
+        #endif
+
+        arQueue.push(frame);
+        obstacleQueue.push(frame);
+
+        if (!Backend::LIVE) {
+            std::this_thread::sleep_for(0.2s); // Iteration speed control not needed when using camera
+        }
+
+        ++iterations;
+    }
+
+    arQueue.close();
+    obstacleQueue.close();
+}
+
+/* --- Odometry Stage --- */
+//Listens on its own LCM instance so receiving never contends with the stages publishing
+template <typename Backend>
+void Pipeline<Backend>::odometryStage() {
+    lcm::LCM odometryLcm;
+    odometryLcm.subscribe("/odometry", &OdometryTracker::handle, &odometry);
+    while (listening) {
+        odometryLcm.handleTimeout(100);
+    }
+}
+
+/* --- AR Tag Stage --- */
+template <typename Backend>
+void Pipeline<Backend>::arStage() {
+    rover_msgs::TargetList arTagsMessage;
+    rover_msgs::Target* arTags = arTagsMessage.targetList;
+    StageStats latencyStats({"CaptureToTargetList"}, mRoverConfig["stats"]["window"].GetInt(),
+                            mRoverConfig["stats"]["publish_interval_ms"].GetInt());
+    rover_msgs::PerceptionStats latencyMessage;
+
+    /* --- AR Tag Initializations --- */
+    TagDetector detector(mRoverConfig);
+
+    //Published as is when AR detection is compiled out
+    for (int i = 0; i < 2; ++i) {
+        arTags[i].distance = DEFAULT_TAG_VAL;
+        arTags[i].bearing = DEFAULT_TAG_VAL;
+        arTags[i].id = DEFAULT_TAG_VAL;
+    }
+
+    Frame frame;
+    while (arQueue.pop(frame)) {
+        #if AR_DETECTION
+            Mat rgb;
+            detector.findARTags(frame.src, frame.depth, rgb, frame.sceneNs);
+            #if AR_RECORD
+                cam.record_ar(rgb);
+            #endif
+
+            detector.updateDetectedTagInfo(arTags);
+
+            #if DEBUG_STREAM
+                //Skipped when the viewer still holds every slot
+                if (TagSnapshot *snapshot = tagSnapshots.beginWrite()) {
+                    snapshot->frame = frame.id;
+                    resize(rgb, snapshot->image, Size(), DEBUG_STREAM_SCALE, DEBUG_STREAM_SCALE, INTER_NEAREST);
+                    detector.drawTags(snapshot->image, DEBUG_STREAM_SCALE);
+                    tagSnapshots.commitWrite();
+                }
+            #endif
+
+            #if PERCEPTION_DEBUG
+                imshow("depth", frame.src);
+                waitKey(1);
+            #endif
+        #endif
+
+        latencyStats.record(0, stampMessage(arTagsMessage, frame));
+        lcm_.publish("/target_list", &arTagsMessage);
+
+        if (latencyStats.publishDue()) {
+            latencyStats.fill(latencyMessage);
+            lcm_.publish("/perception_stats", &latencyMessage);
+        }
+    }
+}
+
+/* --- Obstacle Stage --- */
+template <typename Backend>
+void Pipeline<Backend>::obstacleStage() {
+    rover_msgs::Obstacle obstacleMessage;
+    StageStats latencyStats({"CaptureToObstacle"}, mRoverConfig["stats"]["window"].GetInt(),
+                            mRoverConfig["stats"]["publish_interval_ms"].GetInt());
+    rover_msgs::PerceptionStats latencyMessage;
+
+    /* --- Point Cloud Initializations --- */
+    #if OBSTACLE_DETECTION
+
+    //Constructed here so all PCL (and visualizer) work stays on this thread
+    PCL pointcloud(mRoverConfig);
+    enum viewerType {
+        newView, //set to 0 -or false- to be passed into updateViewer later
+        originalView //set to 1 -or true- to be passed into updateViewer later
+    };
+
+    rover_msgs::PerceptionStats statsMessage;
+    rover_msgs::ObstacleHistogram histogramMessage;
+    histogramMessage.num_sectors = pointcloud.HISTOGRAM_SECTORS;
+    histogramMessage.min_bearing = -pointcloud.MAX_FIELD_OF_VIEW_ANGLE;
+    histogramMessage.sector_width = pointcloud.SECTOR_WIDTH;
+    unsigned configVersion = config.version();
+
+    #endif
+
+    Frame frame;
+    while (obstacleQueue.pop(frame)) {
+
+        /* --- Point Cloud Processing --- */
+        #if OBSTACLE_DETECTION && !WRITE_CURR_FRAME_TO_DISK
+        //Pick up a retuned config between frames
+        if (config.version() != configVersion) {
+            configVersion = config.version();
+            pointcloud.applyConfig(*config.current()->obstacle);
+        }
+
+        #if PERCEPTION_DEBUG
+            //Update Original 3D Viewer
+            pointBufferToCloud(*frame.points, *pointcloud.pt_cloud_ptr);
+            pointcloud.updateViewer(originalView);
+            cout<<"Original W: " <<pointcloud.pt_cloud_ptr->width<<" Original H: "<<pointcloud.pt_cloud_ptr->height<<endl;
+        #endif
+
+        //Run Obstacle Detection, fusing it with earlier frames at the latest pose
+        pointcloud.setPose(odometry.pose());
+        pointcloud.pcl_obstacle_detection(*frame.points, frame.sceneNs);
+
+        //Update LCM
+        obstacleMessage.bearing = pointcloud.leftBearing; // Update LCM bearing field
+        obstacleMessage.rightBearing = pointcloud.rightBearing;
+        obstacleMessage.distance = pointcloud.distance; // Update LCM distance field
+        #if PERCEPTION_DEBUG
+            cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!Path Sent: " << obstacleMessage.bearing << "\n";
+            cout << "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!Distance Sent: " << obstacleMessage.distance << "\n";
+        #endif
+
+        #if PERCEPTION_DEBUG
+            //Update Processed 3D Viewer
+            pointcloud.updateViewer(newView);
+            cout<<"Downsampled W: " <<pointcloud.pt_cloud_ptr->width<<" Downsampled H: "<<pointcloud.pt_cloud_ptr->height<<endl;
+        #endif
+
+        #if DEBUG_STREAM
+            //Skipped when the viewer still holds every slot
+            if (ObstacleSnapshot *snapshot = obstacleSnapshots.beginWrite()) {
+                snapshot->frame = frame.id;
+                snapshot->leftBearing = obstacleMessage.bearing;
+                snapshot->rightBearing = obstacleMessage.rightBearing;
+                snapshot->distance = obstacleMessage.distance;
+                snapshot->points.clear();
+                snapshot->clusters.clear();
+
+                //Every stride-th clustered point, so the copy stays bounded however cluttered the scene
+                size_t clustered = 0;
+                for (const pcl::PointIndices &cluster : pointcloud.cluster_indices) clustered += cluster.indices.size();
+                size_t stride = clustered / DEBUG_STREAM_MAX_POINTS + 1;
+                size_t n = 0;
+                for (size_t c = 0; c < pointcloud.cluster_indices.size(); ++c) {
+                    for (int index : pointcloud.cluster_indices[c].indices) {
+                        if (n++ % stride) continue;
+                        const pcl::PointXYZRGB &point = pointcloud.pt_cloud_ptr->points[index];
+                        snapshot->points.emplace_back(point.x, point.z);
+                        snapshot->clusters.push_back(c);
+                    }
+                }
+                obstacleSnapshots.commitWrite();
+            }
+        #endif
+
+        //Publish the unfiltered histogram every frame, it already holds every obstacle in view
+        if (pointcloud.HISTOGRAM_ENABLED) {
+            histogramMessage.range = pointcloud.sectorRanges;
+            lcm_.publish("/obstacle_histogram", &histogramMessage);
+        }
+
+        //Publish stage latencies
+        if (pointcloud.stats.publishDue()) {
+            pointcloud.stats.fill(statsMessage);
+            lcm_.publish("/perception_stats", &statsMessage);
+        }
+        #endif
+
+        latencyStats.record(0, stampMessage(obstacleMessage, frame));
+        lcm_.publish("/obstacle", &obstacleMessage);
+
+        if (latencyStats.publishDue()) {
+            latencyStats.fill(latencyMessage);
+            lcm_.publish("/perception_stats", &latencyMessage);
+        }
+    }
+}
+
+//Every backend this build can use, main picks one at startup
+template class Pipeline<OfflineBackend>;
+#if ZED_SDK_PRESENT
+template class Pipeline<ZedBackend>;
+#endif
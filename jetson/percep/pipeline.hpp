@@ -0,0 +1,85 @@
+#pragma once
+
+#include "perception.hpp"
+#include "frame_queue.hpp"
+#include "perception_config.hpp"
+#include "debug_stream.hpp"
+#include "obstacle_map.hpp"
+#include "stage_stats.hpp"
+#include <atomic>
+#include "rover_msgs/Target.hpp"
+#include "rover_msgs/TargetList.hpp"
+#include "rover_msgs/ObstacleHistogram.hpp"
+
+/* --- Frame --- */
+//One synchronized capture from the camera
+//Copies of a frame are cheap: the Mats and the point buffer are reference counted
+struct Frame {
+    int id;
+    int64_t captureNs; //system clock when the camera captured it, what latencies are measured from
+    int64_t sceneNs; //system clock when the scene was captured, the recording's time on a replay
+    cv::Mat src;
+    cv::Mat depth;
+    #if OBSTACLE_DETECTION
+    std::shared_ptr<PointBuffer> points;
+    #endif
+};
+
+/* --- Pipeline --- */
+//Runs perception as a set of concurrent stages:
+//capture -> (AR tag detection || obstacle detection)
+//with /odometry received alongside for obstacle fusion
+//Each detection stage publishes its own LCM message, so a slow
+//obstacle frame no longer holds back /target_list and vice versa
+//Specialized for the camera backend frames come from, see camera_backends.hpp
+template <typename Backend>
+class Pipeline {
+public:
+    //Constants
+    int QUEUE_CAPACITY;
+    bool DROP_OLDEST;
+    int PT_CLOUD_WIDTH;
+    int PT_CLOUD_HEIGHT;
+    int DEFAULT_TAG_VAL;
+    double DEBUG_STREAM_SCALE;
+    int DEBUG_STREAM_MAX_POINTS;
+    int DEBUG_STREAM_RING_SIZE;
+    int DEBUG_STREAM_REFRESH_MS;
+
+    Pipeline(const rapidjson::Document &mRoverConfig, Camera<Backend> &cam, lcm::LCM &lcm_, ConfigWatcher &config);
+
+    //Runs all stages until the camera runs out of frames
+    //Capture runs on the calling thread, detection stages get their own threads
+    void run();
+
+private:
+    //Grabs frames from the camera and hands them to both detection stages
+    void captureStage();
+
+    //Finds AR tags and publishes /target_list
+    void arStage();
+
+    //Finds obstacles and publishes /obstacle
+    void obstacleStage();
+
+    //Keeps odometry up to date for obstacle fusion until capture ends
+    void odometryStage();
+
+    const rapidjson::Document &mRoverConfig;
+    Camera<Backend> &cam;
+    lcm::LCM &lcm_;
+    ConfigWatcher &config;
+
+    //Point buffers for captured frames, recycled once every stage is done with them
+    PointBufferPool pointPool;
+
+    FrameQueue<Frame> arQueue;
+    FrameQueue<Frame> obstacleQueue;
+
+    //Annotated snapshots handed from the detection stages to the debug viewer
+    SnapshotRing<TagSnapshot> tagSnapshots;
+    SnapshotRing<ObstacleSnapshot> obstacleSnapshots;
+
+    OdometryTracker odometry;
+    std::atomic<bool> listening;
+};
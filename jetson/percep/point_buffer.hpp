@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* --- Point Buffer --- */
+//Raw point cloud in the ZED's XYZRGBA layout: 4 floats per point, row major
+//The 4th float holds the color packed as bytes R, G, B, A
+//Invalid points are left as NaN and are dropped by the first obstacle filter
+struct PointBuffer {
+    std::vector<float> data;
+    int width;
+    int height;
+
+    PointBuffer(int width_in, int height_in) : data(4 * width_in * height_in), width{width_in}, height{height_in} {}
+
+    //Reallocates only when the dimensions change
+    void resize(int width_in, int height_in) {
+        width = width_in;
+        height = height_in;
+        data.resize(4 * width * height);
+    }
+
+    size_t size() const {
+        return (size_t)width * height;
+    }
+};
+
+/* --- Cloud View --- */
+//Structure of arrays view over an interleaved buffer
+//Component i of point n is at component_i[n * stride], no data is copied
+struct CloudView {
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *rgba;
+    size_t stride;
+    size_t size;
+
+    CloudView(const PointBuffer &points) :
+        x{points.data.data()}, y{points.data.data() + 1}, z{points.data.data() + 2}, rgba{points.data.data() + 3},
+        stride{4}, size{points.size()} {}
+
+    //Unpacks the color of point n into its channels
+    void color(size_t n, uint8_t &r, uint8_t &g, uint8_t &b) const {
+        uint32_t packed;
+        std::memcpy(&packed, &rgba[n * stride], sizeof(packed));
+        r = packed & 0xFF;
+        g = (packed >> 8) & 0xFF;
+        b = (packed >> 16) & 0xFF;
+    }
+};
+
+/* --- Point Buffer Pool --- */
+//Recycles point buffers between frames so capture never allocates once warmed up
+//Buffers handed out return to the pool when their last shared_ptr is released
+//Buffers may outlive the pool, they are freed instead of returned then
+class PointBufferPool {
+public:
+    PointBufferPool(int width, int height, size_t preallocate) : shared_{std::make_shared<Shared>()} {
+        shared_->width = width;
+        shared_->height = height;
+        for (size_t i = 0; i < preallocate; ++i) {
+            shared_->free.emplace_back(new PointBuffer(width, height));
+        }
+    }
+
+    std::shared_ptr<PointBuffer> acquire() {
+        PointBuffer *buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(shared_->mutex);
+            if (!shared_->free.empty()) {
+                buffer = shared_->free.back().release();
+                shared_->free.pop_back();
+            }
+        }
+        //All buffers are in flight, grow the pool instead of stalling capture
+        if (!buffer) {
+            buffer = new PointBuffer(shared_->width, shared_->height);
+        }
+        //The deleter keeps the free list alive, so a buffer still queued
+        //somewhere when the pool is destroyed is simply freed with it
+        std::shared_ptr<Shared> shared = shared_;
+        return std::shared_ptr<PointBuffer>(buffer, [shared](PointBuffer *released) {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->free.emplace_back(released);
+        });
+    }
+
+private:
+    struct Shared {
+        int width;
+        int height;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<PointBuffer>> free;
+    };
+
+    std::shared_ptr<Shared> shared_;
+};
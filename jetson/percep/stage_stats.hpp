@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "rover_msgs/PerceptionStats.hpp"
+
+/* --- Latency Window --- */
+//Keeps the most recent timings of a single stage in a fixed size ring
+//Recording is a single store; percentiles are only computed when stats are published
+class LatencyWindow {
+public:
+    explicit LatencyWindow(size_t capacity) : samples_(capacity ? capacity : 1), next_{0}, count_{0} {}
+
+    void record(double ms) {
+        samples_[next_] = ms;
+        next_ = (next_ + 1) % samples_.size();
+        if (count_ < samples_.size()) ++count_;
+    }
+
+    size_t count() const {
+        return count_;
+    }
+
+    //Returns the p-th percentile (0 to 100) of the window, 0 if empty
+    //sorted is scratch space so repeated calls don't allocate
+    double percentile(double p, std::vector<double> &sorted) const {
+        if (count_ == 0) return 0;
+        sorted.assign(samples_.begin(), samples_.begin() + count_);
+        size_t rank = std::min(count_ - 1, (size_t)(p / 100.0 * count_));
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+
+    double mean() const {
+        if (count_ == 0) return 0;
+        double sum = 0;
+        for (size_t i = 0; i < count_; ++i) sum += samples_[i];
+        return sum / count_;
+    }
+
+    double max() const {
+        if (count_ == 0) return 0;
+        return *std::max_element(samples_.begin(), samples_.begin() + count_);
+    }
+
+private:
+    std::vector<double> samples_;
+    size_t next_;
+    size_t count_;
+};
+
+/* --- Stage Stats --- */
+//Rolling latency windows for a fixed list of pipeline stages
+//Not thread safe, each pipeline thread owns its own StageStats
+class StageStats {
+public:
+    StageStats(const std::vector<std::string> &names, size_t window, int publishIntervalMs) :
+        names_{names}, windows_(names.size(), LatencyWindow(window)),
+        publishInterval_{publishIntervalMs}, lastPublish_{std::chrono::steady_clock::now()} {}
+
+    void record(int stage, double ms) {
+        windows_[stage].record(ms);
+    }
+
+    //True once per publish interval
+    bool publishDue() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastPublish_ < publishInterval_) return false;
+        lastPublish_ = now;
+        return true;
+    }
+
+    void fill(rover_msgs::PerceptionStats &msg) {
+        msg.num_stages = names_.size();
+        msg.stage_names = names_;
+        msg.samples.resize(names_.size());
+        msg.p50_ms.resize(names_.size());
+        msg.p95_ms.resize(names_.size());
+        msg.p99_ms.resize(names_.size());
+        msg.max_ms.resize(names_.size());
+        for (size_t i = 0; i < names_.size(); ++i) {
+            msg.samples[i] = windows_[i].count();
+            msg.p50_ms[i] = windows_[i].percentile(50, scratch_);
+            msg.p95_ms[i] = windows_[i].percentile(95, scratch_);
+            msg.p99_ms[i] = windows_[i].percentile(99, scratch_);
+            msg.max_ms[i] = windows_[i].max();
+        }
+    }
+
+    //Mean of each stage's window, in the order the stages were named
+    std::vector<double> means() const {
+        std::vector<double> result;
+        for (const LatencyWindow &window : windows_) result.push_back(window.mean());
+        return result;
+    }
+
+private:
+    std::vector<std::string> names_;
+    std::vector<LatencyWindow> windows_;
+    std::vector<double> scratch_;
+    std::chrono::milliseconds publishInterval_;
+    std::chrono::steady_clock::time_point lastPublish_;
+};
+
+/* --- Stage Clock --- */
+//Times consecutive stages of one frame
+//lap() records the time since the previous lap into the given stage
+//total() records the time since the clock was created
+class StageClock {
+public:
+    explicit StageClock(StageStats &stats) :
+        stats_(stats), start_{std::chrono::steady_clock::now()}, last_{start_} {}
+
+    void lap(int stage) {
+        auto now = std::chrono::steady_clock::now();
+        stats_.record(stage, std::chrono::duration<double, std::milli>(now - last_).count());
+        last_ = now;
+    }
+
+    void total(int stage) {
+        auto now = std::chrono::steady_clock::now();
+        stats_.record(stage, std::chrono::duration<double, std::milli>(now - start_).count());
+    }
+
+private:
+    StageStats &stats_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/* --- Voxel Hash --- */
+//Maps integer voxel coordinates to dense indices 0, 1, 2, ... in order of insertion
+//Open addressing with linear probing, kept at most half full
+//A slot is occupied only if its stamp matches the current generation,
+//so clear() is constant time and the table is reused across frames
+class VoxelHash {
+public:
+    VoxelHash() : generation_{0}, size_{0} {}
+
+    //Packs voxel coordinates into one key, 21 bits each
+    static uint64_t key(int64_t ix, int64_t iy, int64_t iz) {
+        return ((uint64_t)(ix + (1 << 20)) & 0x1FFFFF) << 42 |
+               ((uint64_t)(iy + (1 << 20)) & 0x1FFFFF) << 21 |
+               ((uint64_t)(iz + (1 << 20)) & 0x1FFFFF);
+    }
+
+    //Voxel coordinate of a value for a given 1 / voxel size
+    static int64_t cell(float value, float inverseSize) {
+        return (int64_t)std::floor(value * inverseSize);
+    }
+
+    //Only reallocates when more entries are needed than ever before
+    void reserve(size_t numEntries) {
+        size_t capacity = 1;
+        while (capacity < 2 * numEntries) capacity <<= 1;
+        if (capacity <= keys_.size()) return;
+
+        keys_.assign(capacity, 0);
+        stamps_.assign(capacity, 0);
+        indices_.assign(capacity, 0);
+        generation_ = 1;
+        size_ = 0;
+    }
+
+    void clear() {
+        //Advance the generation instead of touching every slot
+        if (++generation_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            generation_ = 1;
+        }
+        size_ = 0;
+    }
+
+    //Returns the index of key, giving it the next free index if it is new
+    //The caller must have reserved room for every entry since the last clear
+    uint32_t insert(uint64_t key) {
+        size_t slot = probe(key);
+        if (stamps_[slot] != generation_) {
+            stamps_[slot] = generation_;
+            keys_[slot] = key;
+            indices_[slot] = size_++;
+        }
+        return indices_[slot];
+    }
+
+    //Returns the index of key, or -1 if it was never inserted
+    int64_t find(uint64_t key) const {
+        size_t slot = probe(key);
+        return stamps_[slot] == generation_ ? (int64_t)indices_[slot] : -1;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    //First slot that either holds key or is free
+    size_t probe(uint64_t key) const {
+        const size_t mask = keys_.size() - 1;
+        size_t slot = ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+        while (stamps_[slot] == generation_ && keys_[slot] != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> stamps_;
+    std::vector<uint32_t> indices_;
+    uint32_t generation_;
+    uint32_t size_;
+};